@@ -0,0 +1,403 @@
+#include "ada_beautify.hpp"
+#include "diff.hpp"
+#include "encoding.hpp"
+#include "formatter.hpp"
+#include "keywords.hpp"
+#include "names.hpp"
+#include "syntax.hpp"
+#include "symbol.hpp"
+#include "tokencache.hpp"
+#include "utils.hpp"
+#include "verify.hpp"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace ada_beautify {
+
+void OutputSink::diagnostic(const Diagnostic& diag)
+{
+    // One write, so that diagnostics of parallel calls do not mix:
+    cerr << (diag.file.empty() ? string("<input>") : diag.file) + ":" +
+            to_string(diag.line) + ":" + to_string(diag.column) +
+            ": warning: " + diag.message + "\n";
+}
+
+void CheckSink::write(std::string_view text)
+{
+    if (mismatch)
+        return;
+    const std::string_view have{expected.substr(pos, text.size())};
+    const auto diff = std::mismatch(text.begin(), text.end(),
+                                    have.begin(), have.end());
+    pos += diff.first - text.begin();
+    mismatch = diff.first != text.end();
+}
+
+int CheckSink::line() const
+{
+    return 1 + std::count(expected.begin(),
+                          expected.begin() + std::min(pos, expected.size()),
+                          '\n');
+}
+
+void PassThroughSink::write(std::string_view text)
+{
+    if (same) {
+        if (input.substr(pos, text.size()) == text) {
+            pos += text.size();
+            return;
+        }
+        // The output leaves the input here:
+        flush();
+        same = false;
+        changed = true;
+    }
+    out.write(text);
+}
+
+void PassThroughSink::unit(int line)
+{
+    flush();
+    for (; line_no < line && line_pos < input.size(); ++line_no)
+        line_pos = min(input.find('\n', line_pos), input.size() - 1) + 1;
+    // Input dropped before the unit is a change as well:
+    if (!same || pos != line_pos)
+        changed = true;
+    start = pos = line_pos;
+    same = true;
+    out.unit(line);
+}
+
+void PassThroughSink::finish()
+{
+    flush();
+    if (!same || pos != input.size())
+        changed = true;
+    out.finish();
+}
+
+void PassThroughSink::flush()
+{
+    if (same && pos > start)
+        out.write(input.substr(start, pos - start));
+    start = pos;
+}
+
+// Split text into lines, each with its '\n', if it has one:
+static void split_lines(string_view text, UnifiedDiff::LinesType& lines)
+{
+    while (!text.empty()) {
+        const size_t end = min(text.find('\n'), text.size() - 1) + 1;
+        lines.push_back(text.substr(0, end));
+        text.remove_prefix(end);
+    } // end while //
+}
+
+DiffSink::DiffSink(string_view _input, string_view name, OutputSink& _out):
+    out{_out}, input{_input}, diff{new UnifiedDiff(name, _out)}
+{
+}
+
+DiffSink::~DiffSink()
+{
+}
+
+void DiffSink::diagnostic(const Diagnostic& diag)
+{
+    out.diagnostic(diag);
+}
+
+void DiffSink::unit(int line)
+{
+    // Input lines of the units finished so far:
+    size_t end = pos;
+    for (; pos_line < line && end < input.size(); ++pos_line)
+        end = min(input.find('\n', end), input.size() - 1) + 1;
+    UnifiedDiff::LinesType a, b;
+    split_lines(input.substr(pos, end - pos), a);
+    split_lines(chunk, b);
+    pos = end;
+    diff->compare(a, b);
+    chunk.clear();
+}
+
+void DiffSink::finish()
+{
+    unit(INT_MAX);
+    diff->finish();
+}
+
+// Report the first byte, that is not UTF-8. The text is formatted anyway,
+// bytes out of sequence are taken as Latin-1:
+static void check_utf8(string_view input, const Options& options,
+                       OutputSink& sink)
+{
+    const size_t pos = utf8_error(input);
+    if (pos == string_view::npos)
+        return;
+    const size_t line_start = input.rfind('\n', pos) + 1;
+    sink.diagnostic(Diagnostic{
+            options.file,
+            1 + static_cast<int>(count(input.begin(), input.begin() + pos,
+                                       '\n')),
+            1 + static_cast<int>(text_width(
+                    input.substr(line_start, pos - line_start))),
+            "invalid UTF-8, byte #" +
+            to_hex(static_cast<unsigned char>(input[pos])) +
+            " (use the Latin-1 encoding?)"});
+}
+
+static const char units_magic[8] {'A', 'D', 'A', 'B', 'U', 'N', 'I', 'T'};
+
+bool FormattedUnits::contains(uint64_t hash) const
+{
+    const lock_guard<std::mutex> lock(mutex);
+    return hashes.count(hash);
+}
+
+void FormattedUnits::add(uint64_t hash)
+{
+    const lock_guard<std::mutex> lock(mutex);
+    if (hashes.size() >= maxSize)
+        hashes.clear();
+    hashes.insert(hash);
+}
+
+size_t FormattedUnits::size() const
+{
+    const lock_guard<std::mutex> lock(mutex);
+    return hashes.size();
+}
+
+// File layout: magic, version, count, hash[count] in native byte order:
+void FormattedUnits::load(const string& file)
+{
+    ifstream ifs(file, ios::binary);
+    char magic[8];
+    uint32_t header[2];
+    if (!ifs.read(magic, sizeof(magic)) ||
+        memcmp(magic, units_magic, sizeof(magic)) != 0 ||
+        !ifs.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        header[0] != version || header[1] > maxSize)
+        return;
+    vector<uint64_t> loaded(header[1]);
+    if (!ifs.read(reinterpret_cast<char*>(loaded.data()),
+                  loaded.size() * sizeof(uint64_t)) ||
+        ifs.peek() != char_traits<char>::eof())
+        return;
+    const lock_guard<std::mutex> lock(mutex);
+    hashes.insert(loaded.begin(), loaded.end());
+}
+
+void FormattedUnits::save(const string& file) const
+{
+    vector<uint64_t> saved;
+    {
+        const lock_guard<std::mutex> lock(mutex);
+        saved.assign(hashes.begin(), hashes.end());
+    }
+    const uint32_t header[2]{version, static_cast<uint32_t>(saved.size())};
+    // Write under a private name, so that readers never see half a file:
+    const string temp = file + "." + to_string(getpid()) + "." +
+        to_string(std::hash<thread::id>()(this_thread::get_id())) + ".tmp";
+    error_code ec;
+    filesystem::create_directories(filesystem::path(file).parent_path(), ec);
+    {
+        ofstream ofs(temp, ios::binary);
+        ofs.write(units_magic, sizeof(units_magic));
+        ofs.write(reinterpret_cast<const char*>(header), sizeof(header));
+        ofs.write(reinterpret_cast<const char*>(saved.data()),
+                  saved.size() * sizeof(uint64_t));
+        if (!ofs) {
+            ofs.close();
+            filesystem::remove(temp, ec);
+            return;
+        }
+    }
+    filesystem::rename(temp, file, ec);
+    if (ec)
+        filesystem::remove(temp, ec);
+}
+
+// Hash of the options, that change the layout of a unit:
+static uint64_t layout_hash(const Options& options)
+{
+    const Style& style = options.style;
+    string key = to_string(FormattedUnits::version) + " " +
+        to_string(style.indent) + " " + to_string(style.max_indent) + " " +
+        to_string(style.operator_spacing) + " " +
+        to_string(static_cast<int>(style.keyword_casing)) + " " +
+        to_string(style.comment_width) + " " +
+        to_string(static_cast<int>(options.encoding)) + " " +
+        to_string(options.max_width) + " " + to_string(options.align) +
+        " " + to_string(options.verbose);
+    for (const auto& spelling: options.dictionary)
+        key += " " + spelling;
+    return content_hash(key);
+}
+
+// True for a line, after which a unit may end: it starts in column 1 and
+// ends in ";", and it is no context clause and no generic part, which
+// belong to the unit after:
+static bool unit_end(string_view line)
+{
+    static constexpr array<string_view, 7> context {
+        "generic", "limited", "pragma", "private", "separate", "use", "with"
+    };
+    while (!line.empty() && isspace(static_cast<unsigned char>(line.back())))
+        line.remove_suffix(1);
+    if (line.empty() || !line.ends_with(';') ||
+        !isalpha(static_cast<unsigned char>(line[0])))
+        return false;
+    const string word = to_lower(
+        line.substr(0, min(line.find_first_of(" \t;("), line.size())));
+    return find(context.begin(), context.end(), word) == context.end();
+}
+
+// Split input into spans after the lines, where a top level unit may end.
+// Formatted units end in column 1, elsewhere the formatter tells later,
+// whether a span was a unit with the lines before it:
+static vector<Formatter::Span> split_units(string_view input)
+{
+    vector<Formatter::Span> spans;
+    size_t offset = 0;
+    int line = 1;
+    size_t pos = 0;
+    for (int line_no = 1; pos < input.size(); ++line_no) {
+        const size_t end = min(input.find('\n', pos), input.size() - 1) + 1;
+        if (unit_end(input.substr(pos, end - pos))) {
+            spans.push_back(Formatter::Span{offset, end, line, false, false});
+            offset = end;
+            line = line_no + 1;
+        }
+        pos = end;
+    } // end for //
+    if (offset < input.size())
+        spans.push_back(
+            Formatter::Span{offset, input.size(), line, false, false});
+    return spans;
+}
+
+// Format the symbols of source, copying the units known as formatted, and
+// add the ones, that come out as they went in:
+static void print_units(Formatter& formatter, SymbolSource& source,
+                        string_view input, const Options& options,
+                        OutputSink& out, TokenHash& input_hash)
+{
+    FormattedUnits& units = *options.formatted;
+    vector<Formatter::Span> spans = split_units(input);
+    const uint64_t layout = layout_hash(options);
+    vector<uint64_t> hashes;
+    for (auto& span: spans) {
+        hashes.push_back(layout ^ content_hash(
+            input.substr(span.offset, span.end - span.offset)));
+        span.known = units.contains(hashes.back());
+    } // end for //
+    if (options.verify) {
+        HashingSource hashing(source, input, input_hash);
+        formatter.print(hashing, out, input, spans);
+    } else {
+        formatter.print(source, out, input, spans);
+    }
+    for (size_t i = 0; i < spans.size(); ++i)
+        if (spans[i].formatted && !spans[i].known)
+            units.add(hashes[i]);
+}
+
+void format(std::string_view input, const Options& options, OutputSink& sink)
+{
+    const bool utf8 = options.encoding == Encoding::UTF8;
+    if (utf8)
+        check_utf8(input, options, sink);
+    pmr::memory_resource *memory = options.memory ? options.memory
+                                                  : pmr::get_default_resource();
+    NameTable names(memory);
+    for (const auto& spelling: options.dictionary)
+        names.prefer(spelling);
+    if (options.verbose > 2) {
+        Lexer lexer(input, nullptr, utf8);
+        SyntaxTree tree;
+        tree.parse(lexer);
+        tree.dump(cerr, input);
+    }
+    Formatter formatter(options, names, memory);
+    // Verifying hashes the symbols going in and the text coming out:
+    TokenHash input_hash;
+    VerifySink verify(sink);
+    OutputSink& out = options.verify ? verify : sink;
+    // With first_casing, the first spelling of a name may be in any unit:
+    auto print = [&] (SymbolSource& source) {
+        if (options.formatted && !options.first_casing) {
+            print_units(formatter, source, input, options, out, input_hash);
+        } else if (options.verify) {
+            HashingSource hashing(source, input, input_hash);
+            formatter.print(hashing, out);
+        } else {
+            formatter.print(source, out);
+        }
+    };
+    if (options.token_cache.empty()) {
+        Lexer lexer(input, &names, utf8, memory);
+        print(lexer);
+    } else {
+        // Skip lexing, if this input has been seen before:
+        const TokenCache cache(options.token_cache, input, utf8);
+        if (auto cached = cache.open(names, memory)) {
+            print(*cached);
+        } else {
+            Lexer lexer(input, &names, utf8, memory);
+            TokenRecorder recorder(lexer);
+            print(recorder);
+            cache.save(recorder);
+        }
+    }
+    out.finish();
+    // Output cut short by the sink is not comparable:
+    if (options.verify && !sink.done() && !(verify.hash() == input_hash))
+        throw runtime_error(options.file + ": verification failed, the " +
+                            "output differs in more than layout (" +
+                            to_string(input_hash.symbols()) +
+                            " symbols in, " +
+                            to_string(verify.hash().symbols()) + " out)");
+}
+
+vector<Unit> outline(string_view input)
+{
+    Lexer lexer(input);
+    SyntaxTree tree;
+    tree.parse(lexer);
+    vector<Unit> units;
+    // Units around each node:
+    vector<int> nesting(tree.size(), 0);
+    for (uint32_t i = 1; i < tree.size(); ++i) {
+        const SyntaxTree::Node& n = tree[i];
+        const SyntaxTree::Node& parent = tree[n.parent];
+        nesting[i] = nesting[n.parent] +
+            (parent.kind == SyntaxTree::Kind::UNIT);
+        if (n.kind != SyntaxTree::Kind::UNIT || !n.name_length)
+            continue;
+        string kind{keywords[n.keyword - 1]};
+        if (n.body)
+            kind += " body";
+        units.push_back(Unit{string(input.substr(n.name, n.name_length)),
+                             std::move(kind), nesting[i],
+                             static_cast<int>(n.line),
+                             static_cast<int>(n.end_line)});
+    } // end for //
+    return units;
+}
+
+} // namespace ada_beautify
@@ -0,0 +1,329 @@
+#ifndef ADA_BEAUTIFY_HPP
+#define ADA_BEAUTIFY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace ada_beautify {
+
+/**
+ * @brief Encoding Of the input text. The output keeps it.
+ */
+enum class Encoding
+{
+    UTF8,       // Checked, invalid bytes are reported once
+    LATIN1,     // ISO 8859-1, every byte is a character
+};
+
+/**
+ * @brief Casing Of reserved words in the output.
+ */
+enum class Casing
+{
+    AS_IS,
+    LOWER,
+    UPPER,
+};
+
+/**
+ * @brief Style How the output is laid out. The defaults are the preset
+ *        "default", the layout of the original tool.
+ */
+struct Style
+{
+    int indent{3};                  // Spaces per level
+    int max_indent{80};             // No deeper indentation than this
+    bool operator_spacing{true};    // Blanks around binary operators
+    Casing keyword_casing{Casing::AS_IS};
+    std::size_t comment_width{0};   // Refill wider comments, 0 for never
+};
+
+class FormattedUnits;
+
+/**
+ * @brief Options Settings for one format() call.
+ */
+struct Options
+{
+    int verbose{0};
+    std::string file{};     // Name reported in diagnostics
+    std::string token_cache{};  // Directory for cached symbols, if not empty
+    Encoding encoding{Encoding::UTF8};
+    Style style{};
+
+    // Identifier casing, gnatpp style: spellings from the dictionary win,
+    // else the first spelling in the input, if first_casing is set:
+    bool first_casing{false};
+    std::vector<std::string> dictionary{};
+
+    std::size_t max_width{0};   // Break longer lines, 0 for no limit
+    bool align{false};          // Line up ":", ":=" and "=>" in blocks
+
+    // Throw, if the output differs from the input in more than layout:
+    bool verify{false};
+
+    // Watchdog, format() throws once a limit is exceeded. 0 means no limit:
+    unsigned time_limit{0};         // Milliseconds
+    std::size_t memory_limit{0};    // Bytes of formatted text
+
+    // The state of the call comes from here, if set, else from the heap:
+    // symbols and their text, the names and their spellings, the scopes
+    // and the lines laid out. Only temporaries of the layout do not. None
+    // of it outlives the call, so an arena may drop it all at once after
+    // format() returns:
+    std::pmr::memory_resource *memory{nullptr};
+
+    // Top level units known to come out as they go in are copied, not laid
+    // out, and new ones are added. Not used with first_casing, as there
+    // the casing of one unit depends on the others:
+    FormattedUnits *formatted{nullptr};
+};
+
+/**
+ * @brief Diagnostic A problem found in the input. Formatting continues
+ *        after a diagnostic has been reported.
+ */
+struct Diagnostic
+{
+    std::string file{};
+    int line{0};
+    int column{0};
+    std::string message{};
+};
+
+/**
+ * @brief OutputSink Receives the formatted text and any diagnostics.
+ *        A sink is used by one format() call at a time.
+ */
+class OutputSink
+{
+public:
+    virtual ~OutputSink() = default;
+
+    virtual void write(std::string_view text) = 0;
+    virtual void diagnostic(const Diagnostic& diag);
+    // A top level unit starts at this input line. Everything written
+    // before belongs to the previous units:
+    virtual void unit(int /*line*/) {}
+    // The next output line comes from this input line. Called once per
+    // line and in order, though its text may be written later:
+    virtual void origin(int /*line*/) {}
+    // Formatting stops early, once the sink needs no more output:
+    virtual bool done() const { return false; }
+    // Called once after the last write:
+    virtual void finish() {}
+};
+
+/**
+ * @brief BufferSink Appends the formatted text to a caller owned string.
+ */
+class BufferSink: public OutputSink
+{
+public:
+    BufferSink(std::string& _buffer): buffer{_buffer} {}
+
+    virtual void write(std::string_view text) { buffer.append(text); }
+
+private:
+    std::string& buffer;
+};
+
+/**
+ * @brief CallbackSink Hands every chunk of formatted text to a callback.
+ */
+class CallbackSink: public OutputSink
+{
+public:
+    typedef std::function<void (std::string_view text)> callbackType;
+
+    CallbackSink(callbackType _callback): callback{_callback} {}
+
+    virtual void write(std::string_view text) { callback(text); }
+
+private:
+    callbackType callback;
+};
+
+/**
+ * @brief StreamSink Writes the formatted text to an output stream.
+ */
+class StreamSink: public OutputSink
+{
+public:
+    StreamSink(std::ostream& _os): os{_os} {}
+
+    virtual void write(std::string_view text) {
+        os.write(text.data(), text.size());
+    }
+
+private:
+    std::ostream& os;
+};
+
+/**
+ * @brief CheckSink Compares the formatted text with the expected text
+ *        while it is produced, without storing it. Stops formatting at
+ *        the first difference.
+ */
+class CheckSink: public OutputSink
+{
+public:
+    CheckSink(std::string_view _expected): expected{_expected} {}
+
+    virtual void write(std::string_view text);
+    virtual bool done() const { return mismatch; }
+
+    // True, if the complete output was equal to the expected text:
+    bool matches() const { return !mismatch && pos == expected.size(); }
+    // Line of the first difference in the expected text:
+    int line() const;
+
+private:
+    std::string_view expected;
+    std::size_t pos{0};
+    bool mismatch{false};
+};
+
+/**
+ * @brief PassThroughSink Forwards the formatted text to another sink.
+ *        Runs of output equal to the input are passed on as one slice
+ *        of the input instead of line by line. Comparison restarts at
+ *        every top level unit.
+ */
+class PassThroughSink: public OutputSink
+{
+public:
+    PassThroughSink(std::string_view _input, OutputSink& _out):
+        out{_out}, input{_input} {}
+
+    virtual void write(std::string_view text);
+    virtual void diagnostic(const Diagnostic& diag) { out.diagnostic(diag); }
+    virtual void unit(int line);
+    virtual void origin(int line) { out.origin(line); }
+    virtual bool done() const { return out.done(); }
+    virtual void finish();
+
+    // True, if the complete output was equal to the input:
+    bool unchanged() const { return !changed; }
+
+private:
+    void flush();
+
+    OutputSink& out;
+    std::string_view input;
+    std::size_t start{0};       // Begin of the pending equal run
+    std::size_t pos{0};         // Input position of the next output byte
+    std::size_t line_pos{0};    // Input position of line_no
+    int line_no{1};
+    bool same{true};            // Unit output equal to the input so far
+    bool changed{false};
+};
+
+class UnifiedDiff;
+
+/**
+ * @brief DiffSink Writes a unified diff from the input to the formatted
+ *        text into another sink. The diff is computed per top level unit,
+ *        so only one unit of output is held at a time.
+ */
+class DiffSink: public OutputSink
+{
+public:
+    DiffSink(std::string_view _input, std::string_view name, OutputSink& out);
+    virtual ~DiffSink();
+
+    virtual void write(std::string_view text) { chunk.append(text); }
+    virtual void diagnostic(const Diagnostic& diag);
+    virtual void unit(int line);
+    virtual void finish();
+
+private:
+    OutputSink& out;
+    std::string_view input;
+    std::size_t pos{0};
+    int pos_line{1};
+    std::string chunk{};
+    std::unique_ptr<UnifiedDiff> diff;
+};
+
+/**
+ * @brief FormattedUnits Hashes of top level units, each with the lines
+ *        before it, that format() left as they were. A hash covers the
+ *        text and the options, that change the layout. One set may be
+ *        shared by concurrent calls.
+ */
+class FormattedUnits
+{
+public:
+    // Bump, whenever the layout of some input changes:
+    static const std::uint32_t version = 1;
+    // The set starts anew, once it holds more hashes:
+    static const std::size_t maxSize = 1 << 20;
+
+    bool contains(std::uint64_t hash) const;
+    void add(std::uint64_t hash);
+    std::size_t size() const;
+    // Read the hashes saved in file, if there is a valid one:
+    void load(const std::string& file);
+    // Replace file. Failing to write is not an error, the units are only
+    // laid out again:
+    void save(const std::string& file) const;
+
+private:
+    mutable std::mutex mutex{};
+    std::unordered_set<std::uint64_t> hashes{};
+};
+
+/**
+ * @brief Unit A program unit found by outline().
+ */
+struct Unit
+{
+    std::string name{};         // As written, with dots and quotes
+    std::string kind{};         // "package", "procedure body", ...
+    int depth{0};               // Units around it, 0 for library units
+    int line{0};                // First and last line
+    int end_line{0};
+};
+
+/**
+ * @brief format Beautify Ada source text.
+ *        Holds no global state, so it may be called from many threads
+ *        concurrently as long as every call uses its own sink.
+ * @param input   Source text to format.
+ * @param options Settings for this call.
+ * @param sink    Receives the formatted text.
+ */
+void format(std::string_view input, const Options& options, OutputSink& sink);
+
+/**
+ * @brief set_style Change one setting of a style. Throws a runtime_error,
+ *        if the setting is not known.
+ * @param style   Style to change.
+ * @param setting A preset ("default", "gnat", "compact" or "wide"), or
+ *                "key=value" with one of the keys indent, max-indent,
+ *                operator-spacing (on, off), keyword-case (as-is,
+ *                lower, upper) and comment-width. Blanks around key and
+ *                value are ignored.
+ */
+void set_style(Style& style, std::string_view setting);
+
+/**
+ * @brief outline List the program units of Ada source text without
+ *        formatting it, in the order they start.
+ * @param input   Source text.
+ */
+std::vector<Unit> outline(std::string_view input);
+
+} // namespace ada_beautify
+
+#endif // ADA_BEAUTIFY_HPP
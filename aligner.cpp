@@ -0,0 +1,113 @@
+#include "aligner.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+bool Aligner::parse(Line& line, char& kind, size_t& start)
+{
+    const string_view s = line.text;
+    const size_t indent = s.find_first_not_of(' ');
+    if (indent == string_view::npos || s.compare(indent, 2, "--") == 0)
+        return false;
+    vector<size_t> opens;
+    size_t depth{0};    // Of the token found
+    kind = 0;
+    line.token = line.assign = 0;
+    for (size_t i = indent; i < s.size(); ++i) {
+        const char c = s[i];
+        if (c == '"') {
+            // Doubled quotes just end and start the literal again:
+            const size_t end = s.find('"', i + 1);
+            if (end == string_view::npos)
+                break;
+            i = end;
+        } else if (c == '\'' && i + 2 < s.size() && s[i + 2] == '\'' &&
+                   (i == 0 || !is_tokenchar(s[i - 1]))) {
+            i += 2;     // Character literal
+        } else if (c == '(') {
+            opens.push_back(i);
+        } else if (c == ')') {
+            if (!opens.empty())
+                opens.pop_back();
+        } else if (c == ' ' && i + 2 < s.size()) {
+            // Two characters after the blank, then a blank or the end:
+            const string_view rest = s.substr(i + 1);
+            const bool last = (rest.size() == 2 || rest[2] == ' ');
+            if (!kind) {
+                if (rest.starts_with(": ")) {
+                    kind = ':';
+                } else if (rest.starts_with("=>") && last) {
+                    kind = '=';
+                } else if (rest.starts_with(":=")) {
+                    return false;   // Assignments do not take part
+                }
+                if (kind) {
+                    line.token = i + 1;
+                    depth = opens.size();
+                    start = opens.empty() ? indent : opens.back() + 1;
+                }
+            } else if (kind == ':' && opens.size() == depth &&
+                       rest.starts_with(":=") && last) {
+                line.assign = i + 1;
+                break;
+            }
+        }
+    } // end for //
+    return kind && line.token > start + 1;
+}
+
+void Aligner::put(string_view text, ada_beautify::OutputSink& sink)
+{
+    Line line{pmr::string(text, block.get_allocator()), 0, 0};
+    char k;
+    size_t s;
+    if (!parse(line, k, s)) {
+        flush(sink);
+        sink.write(text);
+        sink.write("\n");
+        return;
+    }
+    if (!block.empty() && (k != kind || s != start))
+        flush(sink);
+    kind = k;
+    start = s;
+    block.push_back(std::move(line));
+    if (block.size() == maxBlock)
+        flush(sink);
+}
+
+size_t Aligner::column(string_view text, size_t pos) const
+{
+    return utf8 ? text_width(text.substr(0, pos)) : pos;
+}
+
+void Aligner::flush(ada_beautify::OutputSink& sink)
+{
+    if (block.size() > 1) {
+        size_t target{0};
+        for (const auto& line: block)
+            target = max(target, column(line.text, line.token));
+        for (auto& line: block) {
+            const size_t pad = target - column(line.text, line.token);
+            line.text.insert(line.token, pad, ' ');
+            if (line.assign)
+                line.assign += pad;
+        } // end for //
+        // The ":=" of initialized declarations in a second column:
+        target = 0;
+        for (const auto& line: block)
+            target = max(target, column(line.text, line.assign));
+        for (auto& line: block) {
+            if (line.assign)
+                line.text.insert(line.assign,
+                                 target - column(line.text, line.assign), ' ');
+        } // end for //
+    }
+    for (const auto& line: block) {
+        sink.write(line.text);
+        sink.write("\n");
+    } // end for //
+    block.clear();
+}
@@ -0,0 +1,52 @@
+#ifndef ALIGNER_HPP
+#define ALIGNER_HPP
+
+#include "ada_beautify.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Aligner Lines up ":" (and the ":=" after it) across consecutive
+ *        declarations and components, and "=>" across consecutive
+ *        associations, like gnatpp does. Lines of a block are held back
+ *        until the first line that does not take part, or until the
+ *        block is maxBlock lines long.
+ */
+class Aligner
+{
+public:
+    // Longer blocks are aligned in parts, to keep memory and latency flat:
+    static const std::size_t maxBlock = 128;
+
+    // Columns count characters, in UTF-8 the bytes of a sequence are one.
+    // The lines held back come from memory:
+    Aligner(bool _utf8, std::pmr::memory_resource *_memory):
+        utf8{_utf8}, block{_memory} {}
+
+    void put(std::string_view line, ada_beautify::OutputSink& sink);
+    void flush(ada_beautify::OutputSink& sink);
+    bool empty() const { return block.empty(); }
+
+private:
+    struct Line {
+        std::pmr::string text;
+        std::size_t token;      // Offset of ":" or "=>"
+        std::size_t assign;     // Offset of ":=" after ":", 0 if none
+    };
+
+    // Fill in where line aligns, false if it does not take part:
+    static bool parse(Line& line, char& kind, std::size_t& start);
+    // Column of the byte at offset pos in text:
+    std::size_t column(std::string_view text, std::size_t pos) const;
+
+    const bool utf8;
+    std::pmr::vector<Line> block;
+    char kind{0};               // ':' or '='
+    std::size_t start{0};       // Column the names of the block start in
+};
+
+#endif // ALIGNER_HPP
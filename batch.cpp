@@ -0,0 +1,171 @@
+#include "batch.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+using namespace filesystem;
+
+void *Arena::Spill::do_allocate(size_t bytes, size_t alignment)
+{
+    void *p = pmr::new_delete_resource()->allocate(bytes, alignment);
+    size += bytes;
+    return p;
+}
+
+void Arena::Spill::do_deallocate(void *p, size_t bytes, size_t alignment)
+{
+    pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+pmr::memory_resource *Arena::begin()
+{
+    // Room for the last file, if it spilled:
+    const size_t wanted = min(max(size + spill.size, initial), limit);
+    if (wanted > size) {
+        buffer.reset(new byte[wanted]);
+        size = wanted;
+    }
+    spill.size = 0;
+    memory.emplace(buffer.get(), size, &spill);
+    return &*memory;
+}
+
+void Arena::end()
+{
+    memory.reset();
+}
+
+Batch::Batch(unsigned _workers, actionType _action):
+    workers{max(_workers, 1u)}, action{_action}
+{
+}
+
+int Batch::run(const vector<path>& files)
+{
+    unique_ptr<FileIO> io{FileIO::create(depth)};
+    mutex lock;
+    condition_variable wake_worker;
+    condition_variable wake_io;
+    deque<FileJob*> todo;
+    FileIO::BatchType finished;
+    bool closing{false};
+
+    auto worker = [this, &lock, &wake_worker, &wake_io,
+                   &todo, &finished, &closing] ()
+    {
+        Arena arena;
+        while (true) {
+            FileJob *job;
+            {
+                unique_lock<mutex> guard(lock);
+                wake_worker.wait(guard, [&] {
+                    return closing || !todo.empty();
+                });
+                if (todo.empty())
+                    return;
+                job = todo.front();
+                todo.pop_front();
+            }
+            job->memory = arena.begin();
+            try {
+                job->passed = action(*job);
+            }
+            catch (const exception& ex) {
+                job->error = ex.what();
+            }
+            job->memory = nullptr;
+            arena.end();
+            {
+                lock_guard<mutex> guard(lock);
+                finished.push_back(job);
+            }
+            wake_io.notify_one();
+        } // end while //
+    };
+    vector<thread> threads;
+    auto stop = [&] () {
+        {
+            lock_guard<mutex> guard(lock);
+            closing = true;
+        }
+        wake_worker.notify_all();
+        for (auto& t: threads)
+            t.join();
+        threads.clear();
+    };
+    for (unsigned i = 0; i < workers; ++i)
+        threads.emplace_back(worker);
+
+    int result{EXIT_SUCCESS};
+    try {
+        vector<unique_ptr<FileJob>> jobs(files.size());
+        const size_t limit{4 * depth};  // Files read, but not yet reported
+        size_t next_read{0};
+        size_t next_report{0};
+        size_t in_flight{0};
+        while (next_report < files.size()) {
+            // Read ahead, while the workers are busy:
+            const bool read_ahead{next_read < files.size() && in_flight < limit};
+            if (read_ahead) {
+                FileIO::BatchType batch;
+                for (; next_read < files.size() && batch.size() < depth;
+                     ++next_read) {
+                    jobs[next_read].reset(new FileJob());
+                    jobs[next_read]->file = files[next_read];
+                    batch.push_back(jobs[next_read].get());
+                } // end for //
+                io->read(batch);
+                in_flight += batch.size();
+                {
+                    lock_guard<mutex> guard(lock);
+                    for (auto job: batch) {
+                        if (job->error.empty())
+                            todo.push_back(job);
+                        else
+                            finished.push_back(job);
+                    } // end for //
+                }
+                wake_worker.notify_all();
+            }
+            // Collect what the workers have finished:
+            FileIO::BatchType done;
+            {
+                unique_lock<mutex> guard(lock);
+                if (!read_ahead)
+                    wake_io.wait(guard, [&] { return !finished.empty(); });
+                done.swap(finished);
+            }
+            // Write back the changed files in one batch:
+            FileIO::BatchType changed;
+            for (auto job: done)
+                if (job->write && job->error.empty())
+                    changed.push_back(job);
+            io->write(changed);
+            for (auto job: done)
+                job->done = true;
+            // Report in order:
+            for (; next_report < next_read && jobs[next_report]->done;
+                 ++next_report) {
+                const FileJob& job = *jobs[next_report];
+                cout << job.report;
+                if (!job.error.empty())
+                    cerr << "Error: " << job.error << endl;
+                if (!job.error.empty() || !job.passed)
+                    result = EXIT_FAILURE;
+                jobs[next_report].reset();
+                --in_flight;
+            } // end for //
+        } // end while //
+    }
+    catch (...) {
+        stop();
+        throw;
+    }
+    stop();
+    return result;
+}
@@ -0,0 +1,82 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include "fileio.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Arena Memory of one worker for one file at a time. Everything is
+ *        taken from a buffer kept from file to file, without a lock, and
+ *        dropped at once when the file is done. A file that does not fit
+ *        spills to the heap, and the buffer grows to its size for the
+ *        next, up to a limit.
+ */
+class Arena
+{
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+
+    // The memory for the next file:
+    std::pmr::memory_resource *begin();
+    // Drop all of it:
+    void end();
+
+private:
+    /**
+     * @brief Spill Takes what does not fit from the heap, and counts it.
+     */
+    class Spill: public std::pmr::memory_resource
+    {
+    public:
+        std::size_t size{0};
+
+    private:
+        virtual void *do_allocate(std::size_t bytes, std::size_t alignment);
+        virtual void do_deallocate(void *p, std::size_t bytes,
+                                   std::size_t alignment);
+        virtual bool do_is_equal(const memory_resource& other) const noexcept
+        {
+            return this == &other;
+        }
+    };
+
+    static constexpr std::size_t initial = 1 << 20;
+    static constexpr std::size_t limit = 64 << 20;
+
+    std::unique_ptr<std::byte[]> buffer{};
+    std::size_t size{0};
+    Spill spill{};
+    std::optional<std::pmr::monotonic_buffer_resource> memory{};
+};
+
+/**
+ * @brief Batch Runs an action on many files. One thread reads and writes
+ *        the files in batches, while worker threads run the action.
+ *        Reports are printed in the order of the files.
+ */
+class Batch
+{
+public:
+    // Returns false, if the file did not pass:
+    typedef std::function<bool (FileJob& job)> actionType;
+
+    Batch(unsigned _workers, actionType _action);
+
+    int run(const std::vector<std::filesystem::path>& files);
+
+private:
+    static const unsigned depth = 64;   // Files per I/O batch
+
+    unsigned workers;
+    actionType action;
+};
+
+#endif // BATCH_HPP
@@ -0,0 +1,228 @@
+#include "diff.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+
+using namespace std;
+
+namespace ada_beautify {
+
+void UnifiedDiff::compare(const LinesType& a, const LinesType& b)
+{
+    Block blk{a, b, {}, {}};
+    const hash<string_view> hasher;
+    blk.ha.reserve(a.size());
+    for (const auto& line: a)
+        blk.ha.push_back(hasher(line));
+    blk.hb.reserve(b.size());
+    for (const auto& line: b)
+        blk.hb.push_back(hasher(line));
+    diff(blk, 0, a.size(), 0, b.size());
+}
+
+void UnifiedDiff::diff(const Block& blk, size_t a0, size_t a1,
+                       size_t b0, size_t b1)
+{
+    // Common prefix:
+    while (a0 < a1 && b0 < b1 && blk.equal(a0, b0)) {
+        same(blk.a[a0]);
+        ++a0;
+        ++b0;
+    } // end while //
+    // Common suffix, reported after the middle part:
+    size_t suffix{0};
+    while (a0 < a1 && b0 < b1 && blk.equal(a1 - 1, b1 - 1)) {
+        --a1;
+        --b1;
+        ++suffix;
+    } // end while //
+    size_t x{0}, y{0};
+    if (a0 == a1 || b0 == b1 || !bisect(blk, a0, a1, b0, b1, x, y)) {
+        for (size_t i = a0; i < a1; ++i)
+            remove(blk.a[i]);
+        for (size_t j = b0; j < b1; ++j)
+            insert(blk.b[j]);
+    } else {
+        diff(blk, a0, x, b0, y);
+        diff(blk, x, a1, y, b1);
+    }
+    for (size_t i = 0; i < suffix; ++i)
+        same(blk.a[a1 + i]);
+}
+
+// Find the middle snake of the shortest edit script (Myers 1986, 4b)
+// and return where to split. Needs space linear in the block size.
+bool UnifiedDiff::bisect(const Block& blk, size_t a0, size_t a1,
+                         size_t b0, size_t b1, size_t& x, size_t& y) const
+{
+    const ptrdiff_t n = a1 - a0;
+    const ptrdiff_t m = b1 - b0;
+    const ptrdiff_t max_d = (n + m + 1) / 2;
+    const ptrdiff_t v_offset = max_d;
+    const ptrdiff_t v_length = 2 * max_d + 2;
+    vector<ptrdiff_t> v1(v_length, -1);
+    vector<ptrdiff_t> v2(v_length, -1);
+    v1[v_offset + 1] = 0;
+    v2[v_offset + 1] = 0;
+    const ptrdiff_t delta = n - m;
+    // The forward path checks for overlap, if delta is odd:
+    const bool front = (delta % 2 != 0);
+    ptrdiff_t k1start{0}, k1end{0}, k2start{0}, k2end{0};
+    auto split = [&] (ptrdiff_t x1, ptrdiff_t y1) {
+        x = a0 + x1;
+        y = b0 + y1;
+        return (x1 > 0 || y1 > 0) && (x1 < n || y1 < m);
+    };
+    for (ptrdiff_t d = 0; d < max_d; ++d) {
+        // Forward path:
+        for (ptrdiff_t k1 = -d + k1start; k1 <= d - k1end; k1 += 2) {
+            const ptrdiff_t k1_offset = v_offset + k1;
+            ptrdiff_t x1;
+            if (k1 == -d || (k1 != d && v1[k1_offset - 1] < v1[k1_offset + 1]))
+                x1 = v1[k1_offset + 1];
+            else
+                x1 = v1[k1_offset - 1] + 1;
+            ptrdiff_t y1 = x1 - k1;
+            while (x1 < n && y1 < m && blk.equal(a0 + x1, b0 + y1)) {
+                ++x1;
+                ++y1;
+            } // end while //
+            v1[k1_offset] = x1;
+            if (x1 > n) {
+                k1end += 2;     // Ran off the right
+            } else if (y1 > m) {
+                k1start += 2;   // Ran off the bottom
+            } else if (front) {
+                const ptrdiff_t k2_offset = v_offset + delta - k1;
+                if (k2_offset >= 0 && k2_offset < v_length &&
+                    v2[k2_offset] != -1 && x1 >= n - v2[k2_offset])
+                    return split(x1, y1);
+            }
+        } // end for //
+        // Reverse path:
+        for (ptrdiff_t k2 = -d + k2start; k2 <= d - k2end; k2 += 2) {
+            const ptrdiff_t k2_offset = v_offset + k2;
+            ptrdiff_t x2;
+            if (k2 == -d || (k2 != d && v2[k2_offset - 1] < v2[k2_offset + 1]))
+                x2 = v2[k2_offset + 1];
+            else
+                x2 = v2[k2_offset - 1] + 1;
+            ptrdiff_t y2 = x2 - k2;
+            while (x2 < n && y2 < m &&
+                   blk.equal(a0 + n - x2 - 1, b0 + m - y2 - 1)) {
+                ++x2;
+                ++y2;
+            } // end while //
+            v2[k2_offset] = x2;
+            if (x2 > n) {
+                k2end += 2;     // Ran off the left
+            } else if (y2 > m) {
+                k2start += 2;   // Ran off the top
+            } else if (!front) {
+                const ptrdiff_t k1_offset = v_offset + delta - k2;
+                if (k1_offset >= 0 && k1_offset < v_length &&
+                    v1[k1_offset] != -1) {
+                    const ptrdiff_t x1 = v1[k1_offset];
+                    const ptrdiff_t y1 = v_offset + x1 - k1_offset;
+                    if (x1 >= n - x2)
+                        return split(x1, y1);
+                }
+            }
+        } // end for //
+    } // end for //
+    return false;
+}
+
+void UnifiedDiff::same(string_view line)
+{
+    equal_lines.push_back(line);
+    ++a_line;
+    ++b_line;
+    if (in_hunk) {
+        // Close the hunk, once the gap is too large for one hunk:
+        if (equal_lines.size() > 2 * context) {
+            flush(context);
+            equal_lines.erase(equal_lines.begin(),
+                              equal_lines.end() - context);
+        }
+    } else if (equal_lines.size() > context) {
+        equal_lines.pop_front();
+    }
+}
+
+void UnifiedDiff::remove(string_view line)
+{
+    change();
+    append(hunk, '-', line);
+    ++a_count;
+    ++a_line;
+}
+
+void UnifiedDiff::insert(string_view line)
+{
+    change();
+    append(added, '+', line);
+    ++b_count;
+    ++b_line;
+}
+
+void UnifiedDiff::change()
+{
+    if (!in_hunk) {
+        in_hunk = true;
+        hunk.clear();
+        a_start = a_line - equal_lines.size();
+        b_start = b_line - equal_lines.size();
+        a_count = b_count = 0;
+    }
+    if (equal_lines.empty())
+        return;
+    hunk.append(added);
+    added.clear();
+    for (const auto& line: equal_lines)
+        append(hunk, ' ', line);
+    a_count += equal_lines.size();
+    b_count += equal_lines.size();
+    equal_lines.clear();
+}
+
+void UnifiedDiff::append(string& text, char prefix, string_view line)
+{
+    text.push_back(prefix);
+    text.append(line);
+    if (line.empty() || line.back() != '\n')
+        text.append("\n\\ No newline at end of file\n");
+}
+
+void UnifiedDiff::flush(size_t trailing)
+{
+    hunk.append(added);
+    added.clear();
+    for (size_t i = 0; i < trailing; ++i)
+        append(hunk, ' ', equal_lines[i]);
+    a_count += trailing;
+    b_count += trailing;
+    if (!header) {
+        header = true;
+        out.write("--- " + name + "\n+++ " + name + "\n");
+    }
+    // An empty range names the line before it:
+    auto range = [] (size_t start, size_t count) {
+        return to_string(count ? start : start - 1) + "," + to_string(count);
+    };
+    out.write("@@ -" + range(a_start, a_count) +
+              " +" + range(b_start, b_count) + " @@\n");
+    out.write(hunk);
+    hunk.clear();
+    in_hunk = false;
+}
+
+void UnifiedDiff::finish()
+{
+    if (in_hunk)
+        flush(min(context, equal_lines.size()));
+    equal_lines.clear();
+}
+
+} // namespace ada_beautify
@@ -0,0 +1,82 @@
+#ifndef DIFF_HPP
+#define DIFF_HPP
+
+#include "ada_beautify.hpp"
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ada_beautify {
+
+/**
+ * @brief UnifiedDiff Writes unified diff hunks for a sequence of line
+ *        blocks. Each block is compared on its own with Myers' linear
+ *        space algorithm, hunks may span several blocks.
+ */
+class UnifiedDiff
+{
+public:
+    typedef std::vector<std::string_view> LinesType;
+
+    UnifiedDiff(std::string_view _name, OutputSink& _out,
+                std::size_t _context = 3):
+        name{_name}, out{_out}, context{_context} {}
+
+    // Compare the next block. Lines include their '\n', if they have one.
+    // Lines of a must stay valid until finish(), lines of b need not.
+    void compare(const LinesType& a, const LinesType& b);
+    void finish();
+
+private:
+    struct Block {
+        const LinesType& a;
+        const LinesType& b;
+        std::vector<std::size_t> ha;
+        std::vector<std::size_t> hb;
+
+        bool equal(std::size_t i, std::size_t j) const {
+            return ha[i] == hb[j] && a[i] == b[j];
+        }
+    };
+
+    void diff(const Block& blk, std::size_t a0, std::size_t a1,
+              std::size_t b0, std::size_t b1);
+    bool bisect(const Block& blk, std::size_t a0, std::size_t a1,
+                std::size_t b0, std::size_t b1,
+                std::size_t& x, std::size_t& y) const;
+
+    void same(std::string_view line);
+    void remove(std::string_view line);
+    void insert(std::string_view line);
+    void change();
+    void append(std::string& text, char prefix, std::string_view line);
+    void flush(std::size_t trailing);
+
+    std::string name;
+    OutputSink& out;
+    std::size_t context;
+    bool header{false};
+
+    // Next line numbers in the old and new text:
+    std::size_t a_line{1};
+    std::size_t b_line{1};
+
+    // Hunk under construction:
+    bool in_hunk{false};
+    std::string hunk{};
+    std::string added{};    // Inserted lines go after the removed ones
+    std::size_t a_start{0};
+    std::size_t b_start{0};
+    std::size_t a_count{0};
+    std::size_t b_count{0};
+
+    // Unchanged lines seen since the last change:
+    std::deque<std::string_view> equal_lines{};
+};
+
+} // namespace ada_beautify
+
+#endif // DIFF_HPP
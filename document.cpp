@@ -1,40 +1,86 @@
 #include "document.hpp"
+#include "keywords.hpp"
 #include "scope.hpp"
+#include "utils.hpp"
 
-#include <iostream>
+#include <algorithm>
 #include <array>
-
-extern int verbose;
+#include <string_view>
+#include <utility>
 
 using namespace std;
 
-static array<char, Document::maxIndent + 1> space;
-
 static void copyOver(Document& doc)
 {
     Scope& scope = doc.scope();
-    string line = scope.lineBuffer.str();
-    if (!line.empty()) {
-        scope.content.push_back(line);
-        scope.lineBuffer.str("");
-    }
+    if (!scope.lineEmpty())
+        doc.pushLine(scope);
     doc.lines.insert(doc.lines.end(),
                      scope.comments.begin(),
                      scope.comments.end());
+    doc.origins.insert(doc.origins.end(),
+                       scope.comment_origins.begin(),
+                       scope.comment_origins.end());
     scope.comments.clear();
+    scope.comment_origins.clear();
     doc.lines.insert(doc.lines.end(),
                      scope.content.begin(),
                      scope.content.end());
+    doc.origins.insert(doc.origins.end(),
+                       scope.content_origins.begin(),
+                       scope.content_origins.end());
     scope.content.clear();
+    scope.content_origins.clear();
 }
 
 static void newLine(Scope& scope, bool force = false)
 {
-    string line = scope.lineBuffer.str();
-    if (force || !line.empty()) {
-        scope.content.push_back(line);
-        scope.lineBuffer.str("");
-    }
+    if (force || !scope.lineEmpty())
+        scope.doc.pushLine(scope);
+}
+
+// Binary operators, sorted. Long lines may break before them:
+static constexpr array<string_view, 19> operators {
+    "&", "*", "**", "+", "-", "/", "/=", "<", "<=", "=", ">", ">=",
+    "and", "and then", "mod", "or", "or else", "rem", "xor",
+};
+
+// Reserved words may be in upper case:
+static bool isOperator(const string& token)
+{
+    return binary_search(operators.begin(), operators.end(), token,
+                         [] (string_view a, string_view b) {
+        return lexicographical_compare(
+            a.begin(), a.end(), b.begin(), b.end(),
+            [] (unsigned char x, unsigned char y) {
+                return tolower(x) < tolower(y);
+            });
+    });
+}
+
+// True, if an operator after sym is binary:
+static bool isOperand(const Symbol& sym)
+{
+    const string_view token = sym.value();
+    switch (sym.kind()) {
+    case Symbol::Kind::IDENTIFIER:
+        // Reserved words and "and then", ... are none, but for ".all":
+        return token.find(' ') == string::npos &&
+            (!keyword(to_lower(token)) || to_lower(token) == "all");
+    case Symbol::Kind::OPERATOR:
+        return token == ")";
+    default:
+        return true;
+    } // end switch //
+}
+
+// Equal but for the case of letters:
+static bool sameWord(string_view a, string_view b)
+{
+    return equal(a.begin(), a.end(), b.begin(), b.end(),
+                 [] (unsigned char x, unsigned char y) {
+        return tolower(x) == tolower(y);
+    });
 }
 
 static void handleEnd(const string& token, Document& doc)
@@ -46,58 +92,66 @@ static void handleEnd(const string& token, Document& doc)
 
 static void handleIdentifier(const string& token, Document& doc) {
     Scope& scope = doc.scope();
+    // Unary "+" and "-" keep the blank before, as they follow no operand:
+    const bool tight = doc.tight(token);
+    const bool binary = tight && doc.afterOperand();
     if (scope.end) {
-        scope.end_id = token;
+        // "end loop Outer" keeps both words, "end A.B" the dots:
+        if (!scope.end_id.empty() && !scope.end_id.ends_with('.'))
+            scope.end_id += ' ';
+        scope.end_id += token;
     } else {
-        if (scope.lineBuffer.str().empty())
+        if (scope.lineEmpty()) {
             scope.lineBuffer << doc.indent() << token;
-        else
-            scope.lineBuffer << (scope.dot ? "" : " ") << token;
+        } else {
+            if (doc.wrapping() && !scope.dot && isOperator(token))
+                doc.mark(LineBreaker::Mark::Kind::BREAK);
+            scope.lineBuffer << (scope.dot || binary ? "" : " ") << token;
+        }
+        if (token == ":=")
+            doc.mark(LineBreaker::Mark::Kind::BREAK);
     }
-    scope.dot = false;
+    scope.dot = tight;
 }
 
 static void handleSemicolon(const string& token, Document& doc)
 {
     Scope& scope = doc.scope();
     if (scope.para) {
-        if (scope.lineBuffer.str().empty())
+        if (scope.lineEmpty())
             scope.lineBuffer << doc.indent() << token;
         else
             scope.lineBuffer << token;
+        doc.mark(LineBreaker::Mark::Kind::BREAK);
     } else if (scope.end) {
         // Copy what is already there:
         newLine(scope);
         // Output the end token with reduced indent:
-        if (scope.end_id == "case") {
-            scope.lineBuffer << doc.indent(-2) << "end "
+        if (sameWord(scope.end_id, "case")) {
+            scope.lineBuffer << doc.indent(-2) << doc.cased("end ")
                              << scope.end_id << token;
             scope.end = false;
             scope.end_id = "";
             copyOver(doc);
             doc.closeScope();
-            Scope& scope2 = doc.scope();
             copyOver(doc);
             doc.closeScope();
-            Scope& scope3 = doc.scope();
         } else if (scope.end_id == "") {
-            scope.lineBuffer << doc.indent(-1) << "end"
+            scope.lineBuffer << doc.indent(-1) << doc.cased("end")
                              << scope.end_id << token;
             scope.end = false;
             scope.end_id = "";
             copyOver(doc);
             doc.closeScope();
-            Scope& scope2 = doc.scope();
         } else {
-            scope.lineBuffer << doc.indent(-1) << "end "
+            scope.lineBuffer << doc.indent(-1) << doc.cased("end ")
                              << scope.end_id << token;
-            if (scope.end_id == "loop")
+            if (sameWord(string_view(scope.end_id).substr(0, 4), "loop"))
                 scope.loop = false;
             scope.end = false;
             scope.end_id = "";
             copyOver(doc);
             doc.closeScope();
-            Scope& scope2 = doc.scope();
         }
     } else {
         // Append token to buffer:
@@ -124,6 +178,12 @@ static void handleIs(const string& token, Document& doc) {
     }
 }
 
+// "is new", "is separate", ... end the declaration, instead of a scope:
+static void handleIsStub(const string& token, Document& doc) {
+    handleIdentifier(token, doc);
+    doc.scope().type = false;
+}
+
 static void handleElse(const string& token, Document& doc) {
     Scope& scope = doc.scope();
     newLine(scope);
@@ -165,7 +225,9 @@ static void handleLoop(const string& token, Document& doc) {
 
 static void handleDot(const string& token, Document& doc) {
     Scope& scope = doc.scope();
-    if (scope.lineBuffer.str().empty())
+    if (scope.end)
+        scope.end_id += token;
+    else if (scope.lineEmpty())
         scope.lineBuffer << doc.indent() << token;
     else
         scope.lineBuffer << token;
@@ -174,16 +236,21 @@ static void handleDot(const string& token, Document& doc) {
 
 static void handleNoLeft(const string& token, Document& doc) {
     Scope& scope = doc.scope();
-    if (scope.lineBuffer.str().empty())
+    if (scope.lineEmpty())
         scope.lineBuffer << doc.indent() << token;
     else
         scope.lineBuffer << token;
     scope.dot = false;
 }
 
+static void handleComma(const string& token, Document& doc) {
+    handleNoLeft(token, doc);
+    doc.mark(LineBreaker::Mark::Kind::BREAK);
+}
+
 static void handleNoRight(const string& token, Document& doc) {
     Scope& scope = doc.scope();
-    if (scope.lineBuffer.str().empty())
+    if (scope.lineEmpty())
         scope.lineBuffer << doc.indent() << token;
     else
         scope.lineBuffer << (scope.dot ? "" : " ") << token;
@@ -195,7 +262,7 @@ static void handleArrow(const string& token, Document& doc) {
     if (scope.para) {
         handleIdentifier(token, doc);
     } else {
-        if (scope.lineBuffer.str().empty())
+        if (scope.lineEmpty())
             scope.lineBuffer << doc.indent() << token;
         else
             scope.lineBuffer << (scope.dot ? "" : " ") << token;
@@ -214,11 +281,11 @@ static void handleWhen(const string& token, Document& doc) {
         if (!(scope.is || scope.loop || scope.exit)) {
             copyOver(doc);
             doc.closeScope();
-            Scope& scope2 = doc.scope();
+        } else {
+            scope.exit = false;
+            scope.loop = false;
+            scope.is = false;
         }
-        scope.exit = false;
-        scope.loop = false;
-        scope.is = false;
         handleIdentifier(token, doc);
     }
 }
@@ -230,7 +297,7 @@ static void handleCase(const string& token, Document& doc) {
 
 static void handleLabel(const string& token, Document& doc) {
     Scope& scope = doc.scope();
-    if (scope.lineBuffer.str().empty())
+    if (scope.lineEmpty())
         scope.lineBuffer << doc.indent() << token;
     else
         scope.lineBuffer << token;
@@ -239,11 +306,13 @@ static void handleLabel(const string& token, Document& doc) {
 
 static void handleOPara(const string& token, Document& doc) {
     handleNoRight(token, doc);
+    doc.mark(LineBreaker::Mark::Kind::OPEN);
     Scope& scope = doc.scope();
     --scope.para;
 }
 
 static void handleCPara(const string& token, Document& doc) {
+    doc.mark(LineBreaker::Mark::Kind::CLOSE);
     handleNoLeft(token, doc);
     Scope& scope = doc.scope();
     ++scope.para;
@@ -251,7 +320,7 @@ static void handleCPara(const string& token, Document& doc) {
 
 static void handleExit(const string& token, Document& doc) {
     Scope& scope = doc.scope();
-    if (scope.lineBuffer.str().empty())
+    if (scope.lineEmpty())
         scope.lineBuffer << doc.indent() + token;
     else
         scope.lineBuffer << " " + token;
@@ -259,142 +328,363 @@ static void handleExit(const string& token, Document& doc) {
 }
 
 static void handleType(const string& token, Document& doc) {
+    handleIdentifier(token, doc);
     Scope& scope = doc.scope();
     scope.type = true;
 }
 
 static void handleNlBefore(const string& token, Document& doc) {
+    doc.resync();
     Scope& scope = doc.scope();
     copyOver(doc);
+    doc.startUnit();
     newLine(scope, true);
     handleIdentifier(token, doc);
 }
 
+// Context clauses and generic parts at library level start the next unit:
+static void handleContext(const string& token, Document& doc) {
+    if (doc.level() == 1 && doc.scope().lineEmpty()) {
+        copyOver(doc);
+        doc.startUnit(true);
+    }
+    handleIdentifier(token, doc);
+}
+
 static void handleRecord(const string& token, Document& doc) {
     Scope& scope = doc.scope();
     if (scope.end) {
-        scope.end_id = "record";
-    } else if (scope.is) {
-        scope.is = false;
-        scope.lineBuffer << " " << token;
-    } else {
-        newLine(scope);
-        scope.lineBuffer << doc.indent() << token;
-        newLine(scope);
-        copyOver(doc);
-        doc.openScope();
+        scope.end_id = token;
+        return;
     }
+    // "null record" has no components:
+    const string_view line = scope.lineBuffer.view();
+    const bool null_record = line.size() >= 4 &&
+        sameWord(line.substr(line.size() - 4), "null") &&
+        (line.size() == 4 || line[line.size() - 5] == ' ');
+    handleIdentifier(token, doc);
+    if (null_record)
+        return;
+    newLine(scope);
+    copyOver(doc);
+    doc.openScope();
 }
 
-const Document::handlerMapType Document::handlerMap {
-    { "begin",     handleBegin     },
-    { "end",       handleEnd       },
-    { "else",      handleElse      },
-    { "is",        handleIs        },
-    { "loop",      handleLoop      },
-    { "then",      handleBegin     },
-    { "when",      handleWhen      },
-    { "case",      handleCase      },
-    { "exit",      handleExit      },
-    { "type",      handleType      },
-    { "record",    handleRecord    },
-    { "package",   handleNlBefore  },
-    { "procedure", handleNlBefore  },
-    { "function",  handleNlBefore  },
-    { ";",         handleSemicolon },
-    { ".",         handleDot       },
-    { ",",         handleNoLeft    },
-    { ")",         handleCPara     },
-    { "(",         handleOPara     },
-    { "<<",        handleNoRight   },
-    { ">>",        handleLabel     },
-    { "=>",        handleArrow     },
-};
+// Handlers by token, sorted. Constant, so nothing is built at startup:
+static constexpr array<pair<string_view, Document::handlerType>, 33> handlers {{
+    { "(",            handleOPara     },
+    { ")",            handleCPara     },
+    { ",",            handleComma     },
+    { ".",            handleDot       },
+    { ";",            handleSemicolon },
+    { "<<",           handleNoRight   },
+    { "=>",           handleArrow     },
+    { ">>",           handleLabel     },
+    { "begin",        handleBegin     },
+    { "case",         handleCase      },
+    { "else",         handleElse      },
+    { "end",          handleEnd       },
+    { "exit",         handleExit      },
+    { "function",     handleNlBefore  },
+    { "generic",      handleContext   },
+    { "is",           handleIs        },
+    { "is abstract",  handleIsStub    },
+    { "is new",       handleIsStub    },
+    { "is null",      handleIsStub    },
+    { "is separate",  handleIsStub    },
+    { "limited",      handleContext   },
+    { "loop",         handleLoop      },
+    { "package",      handleNlBefore  },
+    { "pragma",       handleContext   },
+    { "private",      handleContext   },
+    { "procedure",    handleNlBefore  },
+    { "record",       handleRecord    },
+    { "separate",     handleContext   },
+    { "then",         handleBegin     },
+    { "type",         handleType      },
+    { "use",          handleContext   },
+    { "when",         handleWhen      },
+    { "with",         handleContext   },
+}};
+static_assert(is_sorted(handlers.begin(), handlers.end(),
+                        [] (const auto& a, const auto& b) {
+    return a.first < b.first;
+}));
+
+static Document::handlerType handler(string_view token)
+{
+    auto it = lower_bound(handlers.begin(), handlers.end(), token,
+                          [] (const auto& item, string_view t) {
+        return item.first < t;
+    });
+    return (it != handlers.end() && it->first == token) ? it->second : nullptr;
+}
 
-Document::Document() {
-    space.fill(' ');
-    space[space.size() - 1] = '\0';
-    stack.push(Scope(*this));
+Document::Document(const ada_beautify::Options& _options,
+                   std::pmr::memory_resource *_memory):
+    memory{_memory},
+    options{_options},
+    breaker{_options.max_width, _options.encoding == ada_beautify::Encoding::UTF8},
+    aligner{_options.encoding == ada_beautify::Encoding::UTF8, _memory},
+    reflow{_options.style.comment_width,
+           _options.encoding == ada_beautify::Encoding::UTF8}
+{
+    const ada_beautify::Style& style = options.style;
+    const int levels = style.indent
+        ? (style.max_indent + style.indent - 1) / style.indent : 0;
+    for (int level = 0; level <= levels; ++level)
+        indents.emplace_back(min(level * style.indent, style.max_indent), ' ');
+    stack.emplace(*this, memory);
 }
 
-void Document::addComment(string s) {
+void Document::addComment(string_view s) {
     Scope& currentScope = scope();
-    string i = indent();
+    const string& i = indent();
+    int line = current ? current->line() : 0;
     size_t pos = 0;
-    while ((pos = s.find('\n')) != string::npos) {
-        currentScope.comments.push_back(i + s.substr(0, pos));
-        s.erase(0, pos + 1);
+    size_t start = 0;
+    while ((pos = s.find('\n', start)) != string_view::npos) {
+        currentScope.comments.emplace_back(i).append(
+            s.substr(start, pos - start));
+        currentScope.comment_origins.push_back(line++);
+        start = pos + 1;
     }
-    currentScope.comments.push_back(i + s);
+    currentScope.comments.emplace_back(i).append(s.substr(start));
+    currentScope.comment_origins.push_back(line);
+    produced += i.size() + s.size();
+}
+
+void Document::flushComments()
+{
+    Scope& s = scope();
+    pmr::vector<pmr::string>& comments = s.comments;
+    const size_t first = comments.size();
+    reflow.flush(indent(), comments, s.comment_origins);
+    for (size_t i = first; i < comments.size(); ++i)
+        produced += comments[i].size();
+}
+
+void Document::pushLine(Scope& scope)
+{
+    const string_view line = scope.lineBuffer.view();
+    produced += line.size();
+    if (wrapping() && !scope.marks.empty() && line.size() > options.max_width &&
+        (options.encoding != ada_beautify::Encoding::UTF8 ||
+         text_width(line) > options.max_width))
+        breaker.wrap(line, scope.marks, scope.content);
+    else
+        scope.content.emplace_back(line);
+    // Every part of a wrapped line comes from where the line started:
+    const int origin = scope.origin ? scope.origin
+                                    : current ? current->line() : 0;
+    scope.content_origins.resize(scope.content.size(), origin);
+    scope.origin = 0;
+    scope.lineBuffer.str("");
+    scope.marks.clear();
+}
+
+void Document::mark(LineBreaker::Mark::Kind kind)
+{
+    if (!wrapping())
+        return;
+    Scope& s = scope();
+    s.marks.push_back(LineBreaker::Mark{
+            static_cast<size_t>(s.lineBuffer.tellp()), kind});
 }
 
 void Document::put(const Symbol& sym)
 {
     //cerr << "Put " << sym.value() << endl;
+    current = &sym;
+    if (sym.kind() != Symbol::Kind::NL) {
+        previous_line = last_line;
+        last_line = sym.line();
+    }
+    // A run of comment lines ends at the first other symbol or gap:
+    if (!reflow.empty() && sym.kind() != Symbol::Kind::NL &&
+        (sym.kind() != Symbol::Kind::COMMENT || !reflow.continues(sym.line())))
+        flushComments();
     switch (sym.kind()) {
     case Symbol::Kind::END :
-        return; // Nothing to do with that
+        // Comments after the last unit:
+        copyOver(*this);
+        return;
     case Symbol::Kind::COMMENT :
-        addComment(sym.value());
+        if (options.style.comment_width)
+            reflow.add(string_view(sym.value()).substr(4), sym.line());
+        else
+            addComment(sym.value());
         return;
     case Symbol::Kind::NL :
         // Ignore:
         return;
     default :
-        string token = sym.value();
-        auto item = handlerMap.find(token);
-        if (item == handlerMap.end()) {
-            handleIdentifier(token, *this);
+        // The handlers take the token in a buffer kept from one to the
+        // next:
+        token.assign(sym.value());
+        // Reserved words in upper case have their handler in lower case:
+        const handlerType h = handler(
+            options.style.keyword_casing == ada_beautify::Casing::UPPER
+            ? to_lower(token) : token);
+        if (h) {
+            h(token, *this);
         } else {
-            item->second(token, *this);
+            handleIdentifier(token, *this);
         }
+        if (!options.style.operator_spacing)
+            operand = isOperand(sym);
+        // The output line starts with the first symbol put on it:
+        Scope& s = scope();
+        if (!s.origin && !s.lineEmpty())
+            s.origin = sym.line();
     } // end switch //
 }
 
-const string Document::indent(int offset) const
+const string& Document::indent(int offset) const
+{
+    const int level = stack.size() + offset - 1;
+    return indents[clamp(level, 0, static_cast<int>(indents.size()) - 1)];
+}
+
+string Document::cased(string_view word) const
 {
-    int count = (stack.size() + offset - 1) * spacesPerLevel;
-    if (count < 0)
-        count = 0;
-    if (count > maxIndent)
-        count = maxIndent;
-    return string(&space[space.size() - 1 - count]);
+    string s{word};
+    if (options.style.keyword_casing == ada_beautify::Casing::UPPER)
+        for (auto& c: s)
+            c = toupper(static_cast<unsigned char>(c));
+    return s;
 }
 
-void Document::print(std::ostream& os) const
+bool Document::tight(const string& token) const
 {
-    for_each(lines.begin(), lines.end(), [&os] (const string& s) {
-        os << s << endl;
+    return !options.style.operator_spacing &&
+        !isalpha(static_cast<unsigned char>(token[0])) && isOperator(token);
+}
+
+void Document::print(ada_beautify::OutputSink& sink)
+{
+    for_each(diagnostics.begin(), diagnostics.end(),
+             [&sink] (const ada_beautify::Diagnostic& diag) {
+        sink.diagnostic(diag);
     });
+    auto writeLine = [this, &sink] (size_t i) {
+        // The aligner holds lines back, but keeps their order:
+        sink.origin(origins[i]);
+        if (options.align) {
+            aligner.put(lines[i], sink);
+        } else {
+            sink.write(lines[i]);
+            sink.write("\n");
+        }
+    };
+    const size_t split = unit_line ? unit_index : lines.size();
+    for (size_t i = 0; i < split; ++i)
+        writeLine(i);
+    if (unit_line) {
+        aligner.flush(sink);
+        sink.unit(unit_line);
+    }
+    for (size_t i = split; i < lines.size(); ++i)
+        writeLine(i);
+}
+
+void Document::finish(ada_beautify::OutputSink& sink)
+{
+    aligner.flush(sink);
 }
 
 void Document::clear()
 {
     lines.clear();
+    origins.clear();
+    diagnostics.clear();
+    unit_line = 0;
+}
+
+bool Document::atRest()
+{
+    Scope& s = scope();
+    return level() == 1 && !recovering && !in_context && !operand &&
+        reflow.empty() && aligner.empty() && s.lineEmpty() && !s.end &&
+        !s.is && !s.dot && !s.loop && !s.exit && !s.type &&
+        s.end_id.empty() && !s.para && !s.origin && s.comments.empty() &&
+        s.content.empty() && s.marks.empty();
+}
+
+void Document::passed(int line)
+{
+    previous_line = last_line = line;
+    current = nullptr;
+}
+
+void Document::startUnit(bool context)
+{
+    if (level() != 1)
+        return;
+    // The unit started with its context clause already:
+    if (in_context) {
+        in_context = context;
+        return;
+    }
+    in_context = context;
+    // The unit starts right after the last symbol of the previous one:
+    unit_index = lines.size();
+    unit_line = previous_line + 1;
 }
 
 Scope& Document::scope()
 {
-    if (stack.empty())
-        throw runtime_error("Stack underflow");
     return stack.top();
 }
 
 Scope& Document::openScope()
 {
-    stack.push(Scope(*this));
-    if (verbose)
-        lines.push_back(
+    stack.emplace(*this, memory);
+    if (options.verbose) {
+        lines.emplace_back(
             string("--  << New Scope Level ") + to_string(level()) + " >>");
+        origins.push_back(current ? current->line() : 0);
+    }
     return stack.top();
 }
 
 void Document::closeScope()
 {
-    if (stack.size() == 0)
-        throw runtime_error("stack underflow");
+    if (stack.size() == 1) {
+        // Keep the outermost scope, the input has one "end" too many:
+        error("Unbalanced end of scope");
+        return;
+    }
     stack.pop();      // On regular end
-    if (verbose)
-        lines.push_back(
+    if (options.verbose) {
+        lines.emplace_back(
             string("--  << Cur Scope Level ") + to_string(level()) + " >>");
+        origins.push_back(current ? current->line() : 0);
+    }
+}
+
+void Document::error(const string& message)
+{
+    diagnostics.push_back(ada_beautify::Diagnostic{
+            options.file,
+            current ? current->line() : 0,
+            current ? current->column() : 0,
+            message });
+    recovering = true;
+}
+
+void Document::resync()
+{
+    if (!recovering)
+        return;
+    recovering = false;
+    // Close whatever is left open, so the next unit starts on top level:
+    while (stack.size() > 1) {
+        copyOver(*this);
+        stack.pop();
+    }
+    Scope& top = stack.top();
+    top.end = top.is = top.dot = top.loop = top.exit = top.type = false;
+    top.end_id.clear();
+    top.para = 0;
 }
@@ -1,44 +1,88 @@
 #ifndef DOCUMENT_HPP
 #define DOCUMENT_HPP
 
+#include "ada_beautify.hpp"
+#include "aligner.hpp"
+#include "linebreaker.hpp"
+#include "reflow.hpp"
 #include "scope.hpp"
 #include "symbol.hpp"
 
+#include <deque>
+#include <memory_resource>
 #include <stack>
 #include <string>
-#include <functional>
-#include <map>
+#include <string_view>
+#include <vector>
 
 class Document
 {
 public:
-    typedef std::function<void (const std::string& token, Document& doc)> handlerType;
-    typedef std::map<std::string, handlerType> handlerMapType;
+    typedef void (*handlerType)(const std::string& token, Document& doc);
 
-    static const int spacesPerLevel = 3;
-    static const int maxIndent = 80;
-
-    Document();
+    // Lines and scopes come from memory:
+    Document(const ada_beautify::Options& _options,
+             std::pmr::memory_resource *_memory);
     Document(const Document&) = delete;
     Document(Document&&) = delete;
 
     Scope& scope();
     const Scope& scope() const;
     void put(const Symbol& sym);
-    void addComment(std::string comment);
-    void print(std::ostream &os) const;
+    void addComment(std::string_view comment);
+    // Add the comments held back for refilling:
+    void flushComments();
+    void print(ada_beautify::OutputSink& sink);
+    // Write what print() still holds back:
+    void finish(ada_beautify::OutputSink& sink);
     void clear();
+    // True between top level units, where nothing is open or held back:
+    bool atRest();
+    // The symbols up to the one on line went past without put():
+    void passed(int line);
     Scope& openScope();
     void closeScope();
-    const std::string indent(int offset = 0) const;
+    void error(const std::string& message);
+    void resync();
+    // A library unit starts, or its context clause, if context is set:
+    void startUnit(bool context = false);
+    const std::string& indent(int offset = 0) const;
+    // A reserved word in the casing of the style:
+    std::string cased(std::string_view word) const;
+    // True for an operator, that the style writes without blanks:
+    bool tight(const std::string& token) const;
+    bool afterOperand() const { return operand; }
+    // Move the line under construction into the scope content:
+    void pushLine(Scope& scope);
+    // Remember a place to break the line under construction at:
+    void mark(LineBreaker::Mark::Kind kind);
+    bool wrapping() const { return options.max_width != 0; }
     int level() const { return stack.size(); }
 
-    std::vector<std::string> lines{};
+    std::pmr::memory_resource *const memory;
+    std::pmr::vector<std::pmr::string> lines{memory};
+    std::pmr::vector<int> origins{memory};  // The input line of each of lines
+    std::vector<ada_beautify::Diagnostic> diagnostics{};
+    std::size_t produced{0};    // Bytes of text laid out so far
 
 private:
-    static const handlerMapType handlerMap;
-
-    std::stack<Scope> stack{};
+    const ada_beautify::Options& options;
+    LineBreaker breaker;
+    Aligner aligner;
+    CommentReflow reflow;
+    // Indentation by level, up to the maximum, made once for the style:
+    std::vector<std::string> indents{};
+    std::stack<Scope, std::pmr::deque<Scope>> stack{
+        std::pmr::deque<Scope>(memory)};
+    const Symbol* current{nullptr};
+    std::string token{};         // Text of current for the handlers
+    bool recovering{false};
+    int last_line{0};
+    int previous_line{0};
+    std::size_t unit_index{0};
+    int unit_line{0};
+    bool in_context{false};     // Between a context clause and its unit
+    bool operand{false};        // Last symbol ends an operand
 };
 
 #endif // DOCUMENT_HPP
@@ -0,0 +1,79 @@
+#include "encoding.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+// Number of ASCII bytes at the start of p:
+static size_t ascii_prefix(const unsigned char *p, size_t size)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 32 <= size; i += 32) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 16));
+        // The top bits of the 32 bytes:
+        const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(a)) |
+            static_cast<uint32_t>(_mm_movemask_epi8(b)) << 16;
+        if (mask)
+            return i + countr_zero(mask);
+    } // end for //
+#else
+    for (; i + 32 <= size; i += 32) {
+        uint64_t w[4];
+        memcpy(w, p + i, sizeof(w));
+        if ((w[0] | w[1] | w[2] | w[3]) & 0x8080808080808080ull)
+            break;
+    } // end for //
+#endif
+    while (i < size && p[i] < 0x80)
+        ++i;
+    return i;
+}
+
+size_t utf8_error(string_view text)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t size = text.size();
+    size_t i = 0;
+    for (;;) {
+        i += ascii_prefix(p + i, size - i);
+        if (i == size)
+            return string_view::npos;
+        // Bytes after the first, and the range of the second (RFC 3629):
+        const unsigned char c = p[i];
+        size_t n;
+        unsigned char low = 0x80;
+        unsigned char high = 0xBF;
+        if (c >= 0xC2 && c <= 0xDF) {
+            n = 1;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            n = 2;
+            if (c == 0xE0)
+                low = 0xA0;         // Overlong
+            else if (c == 0xED)
+                high = 0x9F;        // Surrogates
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            n = 3;
+            if (c == 0xF0)
+                low = 0x90;         // Overlong
+            else if (c == 0xF4)
+                high = 0x8F;        // Past U+10FFFF
+        } else {
+            return i;
+        }
+        if (n >= size - i || p[i + 1] < low || p[i + 1] > high)
+            return i;
+        for (size_t k = 2; k <= n; ++k) {
+            if ((p[i + k] & 0xC0) != 0x80)
+                return i;
+        } // end for //
+        i += n + 1;
+    } // end for //
+}
@@ -0,0 +1,16 @@
+#ifndef ENCODING_HPP
+#define ENCODING_HPP
+
+#include <cstddef>
+#include <string_view>
+
+/**
+ * @brief utf8_error Offset of the first byte of text, that is not part of
+ *        a well formed UTF-8 sequence, npos if there is none. Overlong
+ *        forms, surrogates and code points past U+10FFFF are errors.
+ *        Runs of ASCII are passed 32 bytes at a time, with SSE2 where
+ *        the target has it, else a word at a time.
+ */
+std::size_t utf8_error(std::string_view text);
+
+#endif // ENCODING_HPP
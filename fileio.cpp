@@ -0,0 +1,535 @@
+#include "fileio.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define HAVE_IO_URING 1
+#endif
+
+using namespace std;
+
+static string failure(const char *what, const FileJob& job, int error)
+{
+    return string("Unable to ") + what + " \"" + job.file.string() + "\": " +
+        strerror(error);
+}
+
+// Files are written next to where they go, and renamed over them when
+// complete, so that a failed write leaves the source as it was. The name
+// is unique per job:
+static string temporary(const FileJob& job)
+{
+    static atomic<unsigned> count{0};
+    return job.file.string() + ".~" + to_string(getpid()) + "." +
+        to_string(count++);
+}
+
+static const int temporary_flags = O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC;
+
+// A temporary file left over by a crashed run with the same pid is
+// dropped, returns the descriptor or -errno:
+static int open_temporary(const string& temp)
+{
+    int fd = ::open(temp.c_str(), temporary_flags, 0666);
+    if (fd < 0 && errno == EEXIST && unlink(temp.c_str()) == 0)
+        fd = ::open(temp.c_str(), temporary_flags, 0666);
+    return fd < 0 ? -errno : fd;
+}
+
+// Give the written temporary file the mode of the file and rename it
+// over the one a link points to, or drop it, if the write failed:
+static void replace(FileJob& job, const string& temp)
+{
+    if (job.error.empty() && job.mode != 0 &&
+        chmod(temp.c_str(), job.mode & 07777) < 0)
+        job.error = failure("write", job, errno);
+    if (job.error.empty()) {
+        error_code ec;
+        filesystem::path file{job.file};
+        if (filesystem::is_symlink(file, ec))
+            file = filesystem::canonical(file, ec);
+        if (ec)
+            job.error = failure("write", job, ec.value());
+        else if (rename(temp.c_str(), file.c_str()) < 0)
+            job.error = failure("write", job, errno);
+    }
+    if (!job.error.empty())
+        unlink(temp.c_str());
+}
+
+/**
+ * @brief PosixFileIO One open/read/write/close per file.
+ */
+class PosixFileIO: public FileIO
+{
+public:
+    virtual const char *name() const { return "pread/pwrite"; }
+    virtual void read(const BatchType& jobs);
+    virtual void write(const BatchType& jobs);
+};
+
+void PosixFileIO::read(const BatchType& jobs)
+{
+    for (auto job: jobs) {
+        const int fd = ::open(job->file.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) < 0) {
+            job->error = failure("read", *job, errno);
+            if (fd >= 0)
+                ::close(fd);
+            continue;
+        }
+        job->mode = st.st_mode;
+        job->input.resize(st.st_size);
+        size_t done{0};
+        while (done < job->input.size()) {
+            const ssize_t n = pread(fd, job->input.data() + done,
+                                    job->input.size() - done, done);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0)
+                job->error = failure("read", *job, errno);
+            if (n <= 0)
+                break;
+            done += n;
+        } // end while //
+        job->input.resize(done);
+        ::close(fd);
+    } // end for //
+}
+
+void PosixFileIO::write(const BatchType& jobs)
+{
+    for (auto job: jobs) {
+        const string temp = temporary(*job);
+        const int fd = open_temporary(temp);
+        if (fd < 0) {
+            job->error = failure("write", *job, -fd);
+            continue;
+        }
+        size_t done{0};
+        while (done < job->output.size()) {
+            const ssize_t n = pwrite(fd, job->output.data() + done,
+                                     job->output.size() - done, done);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0) {
+                job->error = failure("write", *job, errno);
+                break;
+            }
+            done += n;
+        } // end while //
+        if (::close(fd) < 0 && job->error.empty())
+            job->error = failure("write", *job, errno);
+        replace(*job, temp);
+    } // end for //
+}
+
+#ifdef HAVE_IO_URING
+
+/**
+ * @brief UringFileIO Submits the opens, reads, writes and closes of a
+ *        whole batch with one io_uring_enter() per step.
+ */
+class UringFileIO: public FileIO
+{
+public:
+    typedef vector<io_uring_sqe> OpsType;
+
+    // Null, if io_uring is not available:
+    static unique_ptr<FileIO> open(unsigned depth);
+
+    virtual ~UringFileIO();
+
+    virtual const char *name() const { return "io_uring"; }
+    virtual void read(const BatchType& jobs);
+    virtual void write(const BatchType& jobs);
+
+private:
+    UringFileIO() {}
+
+    void run(const OpsType& ops, vector<int>& results);
+    void transfer(const BatchType& jobs, const vector<int>& fds,
+                  bool reading);
+    void close(const BatchType& jobs, const vector<int>& fds,
+               const char *what);
+
+    int fd{-1};
+    void *sq_ptr{MAP_FAILED};
+    size_t sq_len{0};
+    void *cq_ptr{MAP_FAILED};
+    size_t cq_len{0};
+    io_uring_sqe *sqes{static_cast<io_uring_sqe*>(MAP_FAILED)};
+    size_t sqes_len{0};
+    unsigned entries{0};
+    unsigned *sq_head{nullptr};
+    unsigned *sq_tail{nullptr};
+    unsigned *sq_mask{nullptr};
+    unsigned *sq_array{nullptr};
+    unsigned *cq_head{nullptr};
+    unsigned *cq_tail{nullptr};
+    unsigned *cq_mask{nullptr};
+    io_uring_cqe *cqes{nullptr};
+};
+
+unique_ptr<FileIO> UringFileIO::open(unsigned depth)
+{
+    io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    unique_ptr<UringFileIO> io{new UringFileIO()};
+    io->fd = syscall(__NR_io_uring_setup, depth, &p);
+    if (io->fd < 0)
+        return nullptr;
+    // Kernels before 5.6 set up a ring, but lack the operations used here:
+    static const __u8 needed[] { IORING_OP_OPENAT, IORING_OP_STATX,
+                                 IORING_OP_READ, IORING_OP_WRITE,
+                                 IORING_OP_CLOSE };
+    vector<io_uring_probe_op> probe_buffer(
+        1 + sizeof(io_uring_probe) / sizeof(io_uring_probe_op) + 256);
+    io_uring_probe *probe =
+        reinterpret_cast<io_uring_probe*>(probe_buffer.data());
+    if (syscall(__NR_io_uring_register, io->fd, IORING_REGISTER_PROBE,
+                probe, 256) < 0)
+        return nullptr;
+    for (const __u8 op: needed)
+        if (op > probe->last_op ||
+            !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+            return nullptr;
+    io->entries = p.sq_entries;
+    io->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    io->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        io->sq_len = io->cq_len = max(io->sq_len, io->cq_len);
+    io->sq_ptr = mmap(nullptr, io->sq_len, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, io->fd, IORING_OFF_SQ_RING);
+    if (io->sq_ptr == MAP_FAILED)
+        return nullptr;
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        io->cq_ptr = io->sq_ptr;
+    } else {
+        io->cq_ptr = mmap(nullptr, io->cq_len, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, io->fd,
+                          IORING_OFF_CQ_RING);
+        if (io->cq_ptr == MAP_FAILED)
+            return nullptr;
+    }
+    io->sqes_len = p.sq_entries * sizeof(io_uring_sqe);
+    io->sqes = static_cast<io_uring_sqe*>(
+        mmap(nullptr, io->sqes_len, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, io->fd, IORING_OFF_SQES));
+    if (io->sqes == MAP_FAILED)
+        return nullptr;
+    char *sq = static_cast<char*>(io->sq_ptr);
+    io->sq_head = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+    io->sq_tail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    io->sq_mask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    io->sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    char *cq = static_cast<char*>(io->cq_ptr);
+    io->cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    io->cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    io->cq_mask = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    io->cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+    return io;
+}
+
+UringFileIO::~UringFileIO()
+{
+    if (sqes != MAP_FAILED)
+        munmap(sqes, sqes_len);
+    if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr)
+        munmap(cq_ptr, cq_len);
+    if (sq_ptr != MAP_FAILED)
+        munmap(sq_ptr, sq_len);
+    if (fd >= 0)
+        ::close(fd);
+}
+
+// Submit all operations and wait for them. results[i] gets the result
+// of ops[i]: a value >= 0 or a negative errno.
+void UringFileIO::run(const OpsType& ops, vector<int>& results)
+{
+    results.assign(ops.size(), 0);
+    size_t next{0};
+    size_t completed{0};
+    unsigned queued{0};         // In the ring, not yet taken by the kernel
+    unsigned in_flight{0};      // Taken by the kernel, not yet completed
+    while (completed < ops.size()) {
+        unsigned tail = *sq_tail;
+        while (next < ops.size() && queued + in_flight < entries) {
+            const unsigned index = tail & *sq_mask;
+            sqes[index] = ops[next];
+            sqes[index].user_data = next;
+            sq_array[index] = index;
+            ++tail;
+            ++next;
+            ++queued;
+        } // end while //
+        __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+        const int n = syscall(__NR_io_uring_enter, fd, queued, 1,
+                              IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (n < 0 && errno != EINTR)
+            throw runtime_error(string("io_uring_enter: ") + strerror(errno));
+        if (n > 0) {
+            queued -= n;
+            in_flight += n;
+        }
+        unsigned head = *cq_head;
+        const unsigned cq_end = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != cq_end; ++head) {
+            const io_uring_cqe& cqe = cqes[head & *cq_mask];
+            results[cqe.user_data] = cqe.res;
+            ++completed;
+            --in_flight;
+        } // end for //
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    } // end while //
+}
+
+// Read or write until every job is done or has failed:
+void UringFileIO::transfer(const BatchType& jobs, const vector<int>& fds,
+                           bool reading)
+{
+    const char *what = reading ? "read" : "write";
+    vector<size_t> done(jobs.size(), 0);
+    vector<size_t> active;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        const string& data = reading ? jobs[i]->input : jobs[i]->output;
+        if (fds[i] >= 0 && !data.empty())
+            active.push_back(i);
+    } // end for //
+    OpsType ops;
+    vector<int> results;
+    while (!active.empty()) {
+        ops.assign(active.size(), io_uring_sqe{});
+        for (size_t k = 0; k < active.size(); ++k) {
+            const size_t i = active[k];
+            string& data = reading ? jobs[i]->input : jobs[i]->output;
+            io_uring_sqe& sqe = ops[k];
+            sqe.opcode = reading ? IORING_OP_READ : IORING_OP_WRITE;
+            sqe.fd = fds[i];
+            sqe.addr = reinterpret_cast<__u64>(data.data() + done[i]);
+            sqe.len = data.size() - done[i];
+            sqe.off = done[i];
+        } // end for //
+        run(ops, results);
+        size_t kept{0};
+        for (size_t k = 0; k < active.size(); ++k) {
+            const size_t i = active[k];
+            string& data = reading ? jobs[i]->input : jobs[i]->output;
+            if (results[k] < 0 && results[k] != -EINTR && results[k] != -EAGAIN) {
+                jobs[i]->error = failure(what, *jobs[i], -results[k]);
+                continue;
+            }
+            if (results[k] == 0 && reading) {
+                data.resize(done[i]);   // File got shorter
+                continue;
+            }
+            done[i] += max(results[k], 0);
+            if (done[i] < data.size())
+                active[kept++] = i;
+        } // end for //
+        active.resize(kept);
+    } // end while //
+}
+
+void UringFileIO::close(const BatchType& jobs, const vector<int>& fds,
+                        const char *what)
+{
+    OpsType ops;
+    vector<size_t> index;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (fds[i] < 0)
+            continue;
+        io_uring_sqe sqe{};
+        sqe.opcode = IORING_OP_CLOSE;
+        sqe.fd = fds[i];
+        ops.push_back(sqe);
+        index.push_back(i);
+    } // end for //
+    vector<int> results;
+    run(ops, results);
+    for (size_t k = 0; k < ops.size(); ++k) {
+        FileJob& job = *jobs[index[k]];
+        if (results[k] < 0 && job.error.empty())
+            job.error = failure(what, job, -results[k]);
+    } // end for //
+}
+
+void UringFileIO::read(const BatchType& jobs)
+{
+    // Open and stat every file:
+    vector<struct statx> st(jobs.size());
+    OpsType ops(2 * jobs.size(), io_uring_sqe{});
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        io_uring_sqe& open = ops[2 * i];
+        open.opcode = IORING_OP_OPENAT;
+        open.fd = AT_FDCWD;
+        open.addr = reinterpret_cast<__u64>(jobs[i]->file.c_str());
+        open.open_flags = O_RDONLY | O_CLOEXEC;
+        io_uring_sqe& stat = ops[2 * i + 1];
+        stat.opcode = IORING_OP_STATX;
+        stat.fd = AT_FDCWD;
+        stat.addr = reinterpret_cast<__u64>(jobs[i]->file.c_str());
+        stat.len = STATX_SIZE | STATX_MODE;
+        stat.off = reinterpret_cast<__u64>(&st[i]);
+    } // end for //
+    vector<int> results;
+    run(ops, results);
+    vector<int> fds(jobs.size(), -1);
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        fds[i] = results[2 * i];
+        const int error = fds[i] < 0 ? -fds[i] : -results[2 * i + 1];
+        if (error > 0) {
+            jobs[i]->error = failure("read", *jobs[i], error);
+        } else {
+            jobs[i]->input.resize(st[i].stx_size);
+            jobs[i]->mode = st[i].stx_mode;
+        }
+    } // end for //
+    transfer(jobs, fds, true);
+    close(jobs, fds, "read");
+}
+
+void UringFileIO::write(const BatchType& jobs)
+{
+    OpsType ops(jobs.size(), io_uring_sqe{});
+    vector<string> temps(jobs.size());
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        temps[i] = temporary(*jobs[i]);
+        io_uring_sqe& open = ops[i];
+        open.opcode = IORING_OP_OPENAT;
+        open.fd = AT_FDCWD;
+        open.addr = reinterpret_cast<__u64>(temps[i].c_str());
+        open.len = 0666;
+        open.open_flags = temporary_flags;
+    } // end for //
+    vector<int> fds;
+    run(ops, fds);
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (fds[i] == -EEXIST)
+            fds[i] = open_temporary(temps[i]);
+        if (fds[i] < 0)
+            jobs[i]->error = failure("write", *jobs[i], -fds[i]);
+    } // end for //
+    transfer(jobs, fds, false);
+    close(jobs, fds, "write");
+    for (size_t i = 0; i < jobs.size(); ++i)
+        if (fds[i] >= 0)
+            replace(*jobs[i], temps[i]);
+}
+
+#endif // HAVE_IO_URING
+
+unique_ptr<FileIO> FileIO::create(unsigned depth)
+{
+#ifdef HAVE_IO_URING
+    if (auto io = UringFileIO::open(depth))
+        return io;
+#endif
+    return unique_ptr<FileIO>(new PosixFileIO());
+}
+
+string read_file(const filesystem::path& file)
+{
+    const int fd = file.empty()
+        ? STDIN_FILENO : ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw runtime_error("Unable to open input file \"" +
+                            file.filename().string() + "\": " +
+                            strerror(errno));
+    // Regular files are read in one go, pipes in steps:
+    struct stat st;
+    string text;
+    text.resize(fstat(fd, &st) == 0 && S_ISREG(st.st_mode)
+                ? st.st_size + 1 : 64 * 1024);
+    size_t done{0};
+    for (;;) {
+        if (done == text.size())
+            text.resize(2 * text.size());
+        const ssize_t n = ::read(fd, text.data() + done, text.size() - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0) {
+            const int error = errno;
+            if (fd != STDIN_FILENO)
+                ::close(fd);
+            throw runtime_error("Unable to read \"" +
+                                file.filename().string() + "\": " +
+                                strerror(error));
+        }
+        if (n == 0)
+            break;
+        done += n;
+    } // end for //
+    if (fd != STDIN_FILENO)
+        ::close(fd);
+    text.resize(done);
+    return text;
+}
+
+FdSink::FdSink(const filesystem::path& file):
+    name{file.empty() ? "<stdout>" : file.filename().string()},
+    fd{file.empty()
+       ? STDOUT_FILENO
+       : ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666)}
+{
+    if (fd < 0)
+        throw runtime_error("Unable to open output file \"" + name + "\": " +
+                            strerror(errno));
+    buffer.reserve(64 * 1024);
+}
+
+FdSink::~FdSink()
+{
+    // Output of a failed run is not worth another error:
+    try {
+        flush();
+    }
+    catch (...) {
+    }
+    if (fd != STDOUT_FILENO)
+        ::close(fd);
+}
+
+void FdSink::write(string_view text)
+{
+    if (buffer.size() + text.size() > buffer.capacity())
+        flush();
+    // Large chunks, like a run passed through from the input, go as they are:
+    if (text.size() >= buffer.capacity())
+        put(text);
+    else
+        buffer.append(text);
+}
+
+void FdSink::flush()
+{
+    put(buffer);
+    buffer.clear();
+}
+
+void FdSink::put(string_view data)
+{
+    size_t done{0};
+    while (done < data.size()) {
+        const ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            throw runtime_error("Unable to write \"" + name + "\": " +
+                                strerror(errno));
+        done += n;
+    } // end while //
+}
@@ -0,0 +1,78 @@
+#ifndef FILEIO_HPP
+#define FILEIO_HPP
+
+#include "ada_beautify.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+/**
+ * @brief FileJob One file of a batch run, from reading to writing back.
+ */
+struct FileJob
+{
+    std::filesystem::path file{};
+    std::string input{};
+    unsigned mode{0};       // Of the file, as read, 0 if unknown
+    std::string output{};   // New content, if write is set
+    bool write{false};
+    std::string report{};   // Text for stdout
+    std::string error{};    // Set, if the job failed
+    bool passed{true};      // Set by the action
+    bool done{false};       // Written back, ready to report
+    // For the state of the action, gone when it returns:
+    std::pmr::memory_resource *memory{nullptr};
+};
+
+/**
+ * @brief FileIO Reads and writes whole files in batches.
+ *        Errors are reported in FileJob::error, not thrown.
+ */
+class FileIO
+{
+public:
+    typedef std::vector<FileJob*> BatchType;
+
+    // io_uring, if the kernel allows it, else pread/pwrite:
+    static std::unique_ptr<FileIO> create(unsigned depth);
+
+    virtual ~FileIO() = default;
+
+    virtual const char *name() const = 0;
+    virtual void read(const BatchType& jobs) = 0;
+    virtual void write(const BatchType& jobs) = 0;
+};
+
+// Whole content of file, of stdin for an empty name, read without
+// iostream. Throws a runtime_error, if it cannot be read:
+std::string read_file(const std::filesystem::path& file);
+
+/**
+ * @brief FdSink Writes the formatted text to a file, or to stdout for an
+ *        empty name, through a buffer of its own and without iostream,
+ *        as a single format() call does not need the stream setup.
+ *        Throws a runtime_error, if the file cannot be written.
+ */
+class FdSink: public ada_beautify::OutputSink
+{
+public:
+    FdSink(const std::filesystem::path& file);
+    FdSink(const FdSink&) = delete;
+    virtual ~FdSink();
+
+    virtual void write(std::string_view text);
+    virtual void finish() { flush(); }
+
+private:
+    void flush();
+    void put(std::string_view data);
+
+    std::string name;
+    int fd;
+    std::string buffer{};
+};
+
+#endif // FILEIO_HPP
@@ -2,96 +2,303 @@
 #include "document.hpp"
 
 #include <algorithm>
-#include <memory>
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <stdexcept>
+
+#include <strings.h>
 
 using namespace std;
 
-Formatter::Formatter() {}
+Formatter::Formatter(const ada_beautify::Options& _options,
+                     const NameTable& _names,
+                     std::pmr::memory_resource *_memory):
+    options{_options}, names{_names}, memory{_memory}
+{
+}
 
-void Formatter::optimize()
+// Origin of the input line at pos, as the output line, and go to the next.
+// Empty lines come before a unit, from its first line:
+static int line_origin(string_view input, size_t& pos, int line)
 {
-    // Remove header comments:
-    {
-        while (true) {
-            auto it = symbol_list.begin();
-            if (it == symbol_list.end())
-                break;
-            auto kind = it->get()->kind();
-            if (kind != Symbol::Kind::COMMENT && kind != Symbol::Kind::NL)
-                break;
-            symbol_list.erase(it);
-        } // end while //
+    if (pos >= input.size())
+        return line;
+    const bool empty = input[pos] == '\n';
+    pos = min(input.find('\n', pos), input.size() - 1) + 1;
+    return empty ? line + 1 : line;
+}
+
+/**
+ * @brief SpanSink Forwards to another sink and follows, whether the output
+ *        since start() is the input of a span, line by line.
+ */
+class SpanSink: public ada_beautify::OutputSink
+{
+public:
+    SpanSink(string_view _input, ada_beautify::OutputSink& _out):
+        out{_out}, input{_input} {}
+
+    virtual void write(string_view text) {
+        same = same && input.compare(pos, text.size(), text) == 0;
+        pos += text.size();
+        out.write(text);
     }
-    // "and then", "or else", "is new":
-    {
-        SymbolListType list2;
-        auto iter = symbol_list.begin();
-        while (iter != symbol_list.end()) {
-            const Symbol::Ref ref1 = *iter;
-            if (ref1->value() == "and") {
-                ++iter;
-                const Symbol::Ref ref2 = *iter;
-                if (ref2->value() == "then") {
-                    list2.push_back(Symbol::Ref(
-                        new SymbolIdentifier("and then")));
-                } else {
-                    list2.push_back(ref1);
-                    list2.push_back(ref2);
-                }
-            } else if (ref1->value() == "or") {
-                ++iter;
-                const Symbol::Ref ref2 = *iter;
-                if (ref2->value() == "else") {
-                    list2.push_back(Symbol::Ref(
-                        new SymbolIdentifier("or else")));
-                } else {
-                    list2.push_back(ref1);
-                    list2.push_back(ref2);
-                }
-            } else if (ref1->value() == "is") {
-                ++iter;
-                const Symbol::Ref ref2 = *iter;
-                if (ref2->value() == "new") {
-                    list2.push_back(Symbol::Ref(
-                        new SymbolIdentifier("is new")));
-                } else {
-                    list2.push_back(ref1);
-                    list2.push_back(ref2);
-                }
-            } else {
-                list2.push_back(ref1);
-            }
-            ++iter;
-        } // end while //
-        symbol_list = list2;
+    virtual void diagnostic(const ada_beautify::Diagnostic& diag) {
+        same = false;
+        out.diagnostic(diag);
+    }
+    virtual void unit(int line) {
+        // Once, and after the lines before it:
+        same = same && !unit_line && line == next_line;
+        unit_line = line;
+        out.unit(line);
     }
+    virtual void origin(int line) {
+        same = same && line == line_origin(input, origin_pos, next_line++);
+        out.origin(line);
+    }
+    virtual bool done() const { return out.done(); }
+
+    void start(const Formatter::Span& span) {
+        pos = origin_pos = span.offset;
+        next_line = span.line;
+        unit_line = 0;
+        same = true;
+    }
+    // True, if the output was the span, with its unit on line, 0 if none:
+    bool copied(const Formatter::Span& span, int line) const {
+        return same && pos == span.end && unit_line == line;
+    }
+
+private:
+    ada_beautify::OutputSink& out;
+    string_view input;
+    size_t pos{0};
+    size_t origin_pos{0};       // Input line of the next origin()
+    int next_line{0};
+    int unit_line{0};
+    bool same{false};
+};
+
+// Where the unit of a span starts, after the last line before its code,
+// that is not empty, 0 if it has no code. In a span, that print() wrote
+// as it was, a line is empty or starts with a symbol. Sets last to the
+// last line, that is not empty:
+static int code_line(string_view input, const Formatter::Span& span,
+                     int& last)
+{
+    int rule{0};
+    int line = span.line;
+    for (size_t pos = span.offset; pos < span.end; ++line) {
+        const size_t end = min(input.find('\n', pos), span.end);
+        string_view text = input.substr(pos, end - pos);
+        pos = end + 1;
+        text.remove_prefix(min(text.find_first_not_of(" \t"), text.size()));
+        if (text.empty())
+            continue;
+        const bool comment = text.size() > 2 && text.starts_with("--") &&
+            (text[2] == ' ' || text[2] == '\t');
+        if (!rule && !comment)
+            rule = last + 1;
+        last = line;
+    } // end for //
+    return rule;
 }
 
-void Formatter::print(std::ostream& os)
+// Write a span as print() would, with its unit on line, 0 if none:
+static void copy(string_view input, const Formatter::Span& span, int line,
+                 ada_beautify::OutputSink& sink)
 {
-    optimize();
-    auto doc = shared_ptr<Document>(new Document());
-    for_each(symbol_list.begin(), symbol_list.end(),
-             [&doc, &os] (const Symbol::Ref& sym)
-    {
-        try {
-            doc->put(*sym);
-            doc->print(os);
-            doc->clear();
-        }
-        catch (const exception& ex) {
-            cerr << "Warning: " << ex.what() << endl;
-            doc->print(os);
-            doc->clear();
-            os << endl << "--  <<END OF DOCUMENT>>  --" << endl;
-            doc = shared_ptr<Document>{ new Document() };
+    size_t pos = span.offset;
+    int line_no = span.line;
+    auto lines = [&] (int end_line) {
+        const size_t start = pos;
+        for (; line_no < end_line && pos < span.end; ++line_no)
+            sink.origin(line_origin(input, pos, line_no));
+        if (pos > start)
+            sink.write(input.substr(start, pos - start));
+    };
+    if (line) {
+        lines(line);
+        sink.unit(line);
+    }
+    lines(INT_MAX);
+}
+
+// Equal, but for the case of letters, if fold is set:
+static bool same(const pmr::string& word, const char *s, bool fold)
+{
+    return fold ? strcasecmp(word.c_str(), s) == 0 : word == s;
+}
+
+// Fuse two symbols into one identifier, if the lookahead matches:
+static bool fuse(SymbolSource& lexer, Symbol::Ref& sym,
+                 const char *first, const char *second, bool fold,
+                 pmr::memory_resource *memory)
+{
+    if (!same(sym->value(), first, fold) ||
+        !same(lexer.next()->value(), second, fold))
+        return false;
+    const Symbol::Ref ref1 = sym;
+    const Symbol::Ref ref2 = lexer.get();
+    sym = make_symbol<SymbolIdentifier>(memory,
+                                        string(first) + " " + second);
+    sym->locate(ref1->line(), ref1->column(), ref1->offset(),
+                ref2->offset() + ref2->length() - ref1->offset());
+    return true;
+}
+
+const Symbol::Ref Formatter::optimize(SymbolSource& lexer)
+{
+    Symbol::Ref sym = lexer.get();
+    if (options.verbose > 1)
+        cerr << "Insert " << sym->to_str() << endl;
+    // "and then", "or else", "is new" and the stubs, that open no scope:
+    // Reserved words in any case, if the style sets their casing:
+    const ada_beautify::Casing casing = options.style.keyword_casing;
+    const bool fold = casing != ada_beautify::Casing::AS_IS;
+    const bool fused = fuse(lexer, sym, "and", "then", fold, memory) ||
+        fuse(lexer, sym, "or", "else", fold, memory) ||
+        fuse(lexer, sym, "is", "new", fold, memory) ||
+        fuse(lexer, sym, "is", "separate", fold, memory) ||
+        fuse(lexer, sym, "is", "abstract", fold, memory) ||
+        fuse(lexer, sym, "is", "null", fold, memory);
+    const uint32_t id = sym->id();
+    if (fold && (fused || (id && names.reserved(id)))) {
+        string word{sym->value()};
+        for (auto& c: word)
+            c = (casing == ada_beautify::Casing::UPPER)
+                ? toupper(static_cast<unsigned char>(c))
+                : tolower(static_cast<unsigned char>(c));
+        if (string_view(word) != sym->value()) {
+            const Symbol::Ref ref = sym;
+            sym = make_symbol<SymbolIdentifier>(memory, word);
+            sym->locate(ref->line(), ref->column(), ref->offset(), ref->length());
         }
-        catch (...) {
-            cerr << "Warning: Unknown failure" << endl;
-            doc->print(os);
-            doc->clear();
-            os << endl << "--  <<END OF DOCUMENT>>  --" << endl;
-            doc = shared_ptr<Document>{ new Document() };
+        return sym;
+    }
+    // Identifier casing, reserved words keep theirs:
+    if (id && !names.reserved(id) &&
+        (options.first_casing || names.preferred(id))) {
+        const pmr::string& spelling = names.canonical(id);
+        if (&spelling != &sym->value()) {
+            const Symbol::Ref ref = sym;
+            sym = make_symbol<SymbolIdentifier>(
+                memory, NameTable::Name{id, &spelling});
+            sym->locate(ref->line(), ref->column(), ref->offset(), ref->length());
         }
-    });
+    }
+    return sym;
+}
+
+// Give up on inputs that take too long or blow up:
+void Formatter::watchdog(const Document& doc) const
+{
+    if (options.time_limit) {
+        const auto elapsed = chrono::duration_cast<chrono::milliseconds>(
+            chrono::steady_clock::now() - start);
+        if (elapsed.count() > options.time_limit)
+            throw runtime_error(options.file + ": time limit of " +
+                                to_string(options.time_limit) +
+                                " ms exceeded");
+    }
+    if (options.memory_limit && doc.produced > options.memory_limit)
+        throw runtime_error(options.file + ": memory limit of " +
+                            to_string(options.memory_limit) +
+                            " bytes exceeded");
+}
+
+void Formatter::print(SymbolSource& lexer, ada_beautify::OutputSink& sink)
+{
+    Document doc(options, memory);
+    start = chrono::steady_clock::now();
+    size_t count{0};
+    Symbol::Ref sym = optimize(lexer);
+    // Remove header comments:
+    while (sym == Symbol::Kind::COMMENT || sym == Symbol::Kind::NL)
+        sym = optimize(lexer);
+    while (true) {
+        doc.put(*sym);
+        doc.print(sink);
+        doc.clear();
+        if (sym == Symbol::Kind::END || sink.done())
+            break;
+        if (++count % watchdogInterval == 0)
+            watchdog(doc);
+        sym = optimize(lexer);
+    } // end while //
+    doc.finish(sink);
+}
+
+void Formatter::print(SymbolSource& lexer, ada_beautify::OutputSink& out,
+                      string_view input, vector<Span>& spans)
+{
+    Document doc(options, memory);
+    SpanSink sink(input, out);
+    start = chrono::steady_clock::now();
+    size_t count{0};
+    Symbol::Ref sym = optimize(lexer);
+    // Remove header comments, the first span is not copied then:
+    const bool header = sym == Symbol::Kind::COMMENT ||
+        sym == Symbol::Kind::NL;
+    while (sym == Symbol::Kind::COMMENT || sym == Symbol::Kind::NL)
+        sym = optimize(lexer);
+    size_t next{0};             // The span sym may open
+    int last{0};                // Line of the last symbol but NL
+    int rule{0};                // Where the unit of the span starts, if known
+    bool following{false};      // Output of the open span is followed
+    // The unit of a span starts after the last symbol before its code:
+    auto track = [&] (const Symbol::Ref& s) {
+        if (s == Symbol::Kind::NL || s == Symbol::Kind::END)
+            return;
+        if (!rule && s != Symbol::Kind::COMMENT)
+            rule = last + 1;
+        last = s->line();
+    };
+    while (true) {
+        while (next < spans.size() && (sym == Symbol::Kind::END ||
+                                       sym->offset() >= spans[next].offset)) {
+            if (following)
+                spans[next - 1].formatted =
+                    doc.atRest() && sink.copied(spans[next - 1], rule);
+            Span& span = spans[next++];
+            following = doc.atRest() && !(header && span.offset == 0);
+            rule = 0;
+            if (!following || !span.known || sym == Symbol::Kind::END ||
+                sym->offset() >= span.end) {
+                sink.start(span);
+                continue;
+            }
+            // Copy the span and go on after it:
+            rule = code_line(input, span, last);
+            if (!lexer.skip(span.end, next < spans.size() ? spans[next].line
+                                                          : 0))
+                while (lexer.next() != Symbol::Kind::END &&
+                       lexer.next()->offset() < span.end)
+                    lexer.get();
+            copy(input, span, rule, sink);
+            doc.passed(last);
+            span.formatted = true;
+            following = false;
+            sym = optimize(lexer);
+        } // end while //
+        if (following)
+            track(sym);
+        else if (sym != Symbol::Kind::NL && sym != Symbol::Kind::END)
+            last = sym->line();
+        doc.put(*sym);
+        doc.print(sink);
+        doc.clear();
+        if (sym == Symbol::Kind::END || sink.done())
+            break;
+        if (++count % watchdogInterval == 0)
+            watchdog(doc);
+        sym = optimize(lexer);
+    } // end while //
+    doc.finish(sink);
+    // The last span ends with the input:
+    if (following && sym == Symbol::Kind::END && !sink.done())
+        spans[next - 1].formatted =
+            doc.atRest() && sink.copied(spans[next - 1], rule);
 }
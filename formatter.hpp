@@ -1,25 +1,56 @@
 #ifndef FORMATTER_HPP
 #define FORMATTER_HPP
 
+#include "ada_beautify.hpp"
+#include "names.hpp"
 #include "symbol.hpp"
 
+#include <chrono>
+#include <cstddef>
 #include <list>
-#include <iostream>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+class Document;
 
 class Formatter
 {
 public:
     typedef std::list<Symbol::Ref> SymbolListType;
 
-    Formatter();
-
-    void add(Symbol::Ref& sym) { symbol_list.push_back(sym); }
-    void print(std::ostream& os);
+    // Symbols and the document come from memory:
+    Formatter(const ada_beautify::Options& _options, const NameTable& _names,
+              std::pmr::memory_resource *_memory);
+
+    /**
+     * @brief Span A part of the input, that may be a top level unit with
+     *        the lines before it: from offset up to end, starting on line.
+     */
+    struct Span {
+        std::size_t offset;
+        std::size_t end;
+        int line;
+        bool known;         // Copied, if nothing is open before it
+        bool formatted;     // Set by print(), if the output is the input
+    };
+
+    void print(SymbolSource& lexer, ada_beautify::OutputSink& sink);
+    // The same for the input text of lexer split into spans, in order:
+    void print(SymbolSource& lexer, ada_beautify::OutputSink& sink,
+               std::string_view input, std::vector<Span>& spans);
 
 private:
-    SymbolListType symbol_list{};
+    // Symbols between two looks at the limits:
+    static const unsigned watchdogInterval = 1024;
+
+    const ada_beautify::Options& options;
+    const NameTable& names;
+    std::pmr::memory_resource *memory;
+    std::chrono::steady_clock::time_point start{};
 
-    void optimize();
+    const Symbol::Ref optimize(SymbolSource& lexer);
+    void watchdog(const Document& doc) const;
 };
 
 #endif // FORMATTER_HPP
@@ -0,0 +1,89 @@
+#include "ada_beautify.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Slowest acceptable throughput is the one of a linear input divided by
+// ADA_BEAUTIFY_FUZZ_SLOWDOWN, measured at the first input so that it holds
+// on slow boxes and under load. ADA_BEAUTIFY_FUZZ_FLOOR sets it in bytes
+// per second instead, 0 turns the check off:
+static const double defaultSlowdown = 20;
+// Slack for tiny inputs, as bytes at the floor:
+static const double slackBytes = 16 * 1024;
+
+/**
+ * @brief NullSink Counts the formatted text, drops the diagnostics.
+ */
+class NullSink: public ada_beautify::OutputSink
+{
+public:
+    void write(string_view text) override { size += text.size(); }
+    void diagnostic(const ada_beautify::Diagnostic&) override {}
+
+    size_t size{0};
+};
+
+static double environment(const char *name, double value)
+{
+    const char *text = getenv(name);
+    return text && *text ? strtod(text, nullptr) : value;
+}
+
+static double format_seconds(string_view input)
+{
+    ada_beautify::Options options;
+    options.file = "<fuzz>";
+    NullSink out;
+    ada_beautify::PassThroughSink sink(input, out);
+    const auto start = chrono::steady_clock::now();
+    ada_beautify::format(input, options, sink);
+    const chrono::duration<double> elapsed =
+        chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// Best of a few runs on plain code:
+static double calibrate()
+{
+    static const string_view line = "procedure P is begin null; end P;\n";
+    string input;
+    while (input.size() < 256 * 1024)
+        input += line;
+    double best = format_seconds(input);
+    for (int i = 0; i < 2; ++i)
+        best = min(best, format_seconds(input));
+    return input.size() / best;
+}
+
+static double floor_bytes_per_second()
+{
+    const double floor = environment("ADA_BEAUTIFY_FUZZ_FLOOR", -1);
+    if (floor >= 0)
+        return floor;
+    const double slowdown = environment("ADA_BEAUTIFY_FUZZ_SLOWDOWN",
+                                        defaultSlowdown);
+    return calibrate() / max(slowdown, 1.0);
+}
+
+// Format one input, termination is watched by the driver:
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static const double floorBytesPerSecond = floor_bytes_per_second();
+    const string_view input(reinterpret_cast<const char*>(data), size);
+    const double seconds = format_seconds(input);
+    if (floorBytesPerSecond > 0 &&
+        seconds > (size + slackBytes) / floorBytesPerSecond) {
+        fprintf(stderr, "%zu bytes took %.3f s, below %.0f bytes/s\n",
+                size, seconds, floorBytesPerSecond);
+        abort();
+    }
+    return 0;
+}
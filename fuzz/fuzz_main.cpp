@@ -0,0 +1,119 @@
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+// Driver for compilers without libFuzzer. Replays the files given,
+// else runs adversarial inputs and -runs=<n> random ones.
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static const unsigned timeoutSeconds = 10;
+
+static void timeout(int)
+{
+    static const char message[] = "Timeout, the input did not terminate\n";
+    if (write(STDERR_FILENO, message, sizeof(message) - 1) < 0)
+        _exit(EXIT_FAILURE);
+    abort();
+}
+
+static void run(const string& input)
+{
+    alarm(timeoutSeconds);
+    LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(input.data()),
+                           input.size());
+    alarm(0);
+}
+
+static string repeat(const string& text, size_t size)
+{
+    string result;
+    result.reserve(size + text.size());
+    while (result.size() < size)
+        result += text;
+    return result;
+}
+
+// Inputs that used to hang or to be slow:
+static vector<string> adversarial()
+{
+    const size_t big = 1 << 20;
+    return {
+        "\"", "'", "#", "#4", "--", "-- ", "X := \"abc", "C := '",
+        "\"\"\"", "''", "'\n'", "#zz", "end;", "end",
+        repeat("\"", big),
+        repeat("'", big),
+        repeat("#", big),
+        repeat("A ", big),
+        repeat("A.", big),
+        repeat("(", big),
+        repeat(")", big),
+        repeat("begin ", big),
+        repeat("end; ", big),
+        repeat("case X is when ", big),
+        repeat("loop ", big),
+        repeat("-- comment\n", big),
+        repeat("\n", big),
+        repeat("procedure P is begin null; end P;\n", big),
+        string(big, '\xff'),
+        string(big, '\0'),
+    };
+}
+
+int main(int argc, char *argv[])
+{
+    signal(SIGALRM, timeout);
+    unsigned long runs{1000};
+    vector<string> files;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "-runs=", 6) == 0)
+            runs = strtoul(argv[i] + 6, nullptr, 10);
+        else
+            files.push_back(argv[i]);
+    } // end for //
+
+    if (!files.empty()) {
+        for (const auto& file: files) {
+            ifstream ifs(file, ios::binary);
+            if (!ifs.is_open()) {
+                fprintf(stderr, "Unable to open \"%s\"\n", file.c_str());
+                return EXIT_FAILURE;
+            }
+            stringstream ss;
+            ss << ifs.rdbuf();
+            run(ss.str());
+        } // end for //
+        printf("Replayed %zu inputs\n", files.size());
+        return EXIT_SUCCESS;
+    }
+
+    const vector<string> inputs{adversarial()};
+    for (const auto& input: inputs)
+        run(input);
+    // Random text, biased towards the characters the lexer cares about:
+    static const char alphabet[] = "abeginodlsptrcwhxy_019 \t\n\r;:.,()=<>'\"#-+*/&|";
+    mt19937 rng(4711);
+    for (unsigned long i = 0; i < runs; ++i) {
+        const size_t size = rng() % 4096;
+        string input(size, '\0');
+        const bool raw = (i % 4 == 0);
+        for (auto& ch: input)
+            ch = raw ? static_cast<char>(rng())
+                     : alphabet[rng() % (sizeof(alphabet) - 1)];
+        run(input);
+    } // end for //
+    printf("Ran %zu adversarial and %lu random inputs\n",
+           inputs.size(), runs);
+    return EXIT_SUCCESS;
+}
@@ -4,10 +4,10 @@
 #include <stdio.h>
 
 static int     opterr = 1,             /* if error message should be printed */
-               optind = 1,             /* index into parent argv vector */
                optopt,                 /* character checked for validity */
                optreset;               /* reset getopt */
-const char    *optarg;                 /* argument associated with option */
+int            optind = 1;             /* index into parent argv vector */
+char          *optarg;                 /* argument associated with option */
 
 #define BADCH   (int)'?'
 #define BADARG  (int)':'
@@ -17,7 +17,7 @@ const char    *optarg;                 /* argument associated with option */
 * getopt --
 *      Parse argc/argv argument vector.
 */
-int getopt(int nargc, char * nargv[], const char *ostr)
+int getopt(int nargc, char * const nargv[], const char *ostr)
 {
   static const char *place = EMSG;        /* option letter processing */
   const char *oli;                        /* option letter list index */
@@ -54,7 +54,7 @@ int getopt(int nargc, char * nargv[], const char *ostr)
       ++optind;
   } else {                                /* need an argument */
     if (*place)                           /* no white space */
-      optarg = place;
+      optarg = (char *)place;
     else if (nargc <= ++optind) {         /* no arg */
       place = EMSG;
       if (*ostr == ':')
@@ -14,12 +14,17 @@ extern "C" {
  *               by a colon.
  * @return
  */
-int getopt(int nargc, char *nargv[], const char *ostr);
+int getopt(int nargc, char * const nargv[], const char *ostr);
 
 /**
  * @brief optarg Argument of option.
  */
-extern const char *optarg;
+extern char *optarg;
+
+/**
+ * @brief optind Index of the next argument in argv to process.
+ */
+extern int optind;
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,65 @@
+#include "git.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace filesystem;
+
+extern char **environ;
+
+vector<path> changed_since(const string& rev)
+{
+    // No shell, rev is passed on as it is:
+    const char *const argv[] {
+        "git", "diff", "--name-only", "-z", "--diff-filter=AMR",
+        "--relative", "--end-of-options", rev.c_str(),
+        "--", "*.adb", "*.ads", "*.ada", nullptr
+    };
+    int fds[2];
+    if (pipe(fds) != 0)
+        throw runtime_error(string("Unable to run git: ") + strerror(errno));
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    posix_spawn_file_actions_addclose(&actions, fds[1]);
+    pid_t pid;
+    const int error = posix_spawnp(&pid, "git", &actions, nullptr,
+                                   const_cast<char *const *>(argv), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    if (error) {
+        close(fds[0]);
+        throw runtime_error(string("Unable to run git: ") + strerror(error));
+    }
+
+    string names;
+    char buffer[4096];
+    ssize_t size;
+    while ((size = read(fds[0], buffer, sizeof(buffer))) != 0) {
+        if (size < 0 && errno == EINTR)
+            continue;
+        if (size < 0)
+            break;
+        names.append(buffer, size);
+    } // end while //
+    close(fds[0]);
+    int status;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+        ;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw runtime_error("git diff failed for \"" + rev + "\"");
+
+    // Names end with '\0':
+    vector<path> files;
+    for (size_t pos = 0, end; (end = names.find('\0', pos)) != string::npos;
+         pos = end + 1)
+        files.emplace_back(names.substr(pos, end - pos));
+    return files;
+}
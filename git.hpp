@@ -0,0 +1,16 @@
+#ifndef GIT_HPP
+#define GIT_HPP
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/**
+ * @brief changed_since Ada sources below the current directory, that were
+ *        added, modified or renamed since revision rev, staged or not.
+ *        Asks the local git, so the cost follows the size of the change.
+ *        Throws, if git fails.
+ */
+std::vector<std::filesystem::path> changed_since(const std::string& rev);
+
+#endif // GIT_HPP
@@ -0,0 +1,28 @@
+#ifndef KEYWORDS_HPP
+#define KEYWORDS_HPP
+
+#include <algorithm>
+#include <array>
+#include <string_view>
+
+// Reserved words of Ada 2012, sorted:
+constexpr std::array<std::string_view, 73> keywords {
+    "abort", "abs", "abstract", "accept", "access", "aliased", "all", "and",
+    "array", "at", "begin", "body", "case", "constant", "declare", "delay",
+    "delta", "digits", "do", "else", "elsif", "end", "entry", "exception",
+    "exit", "for", "function", "generic", "goto", "if", "in", "interface",
+    "is", "limited", "loop", "mod", "new", "not", "null", "of", "or",
+    "others", "out", "overriding", "package", "pragma", "private",
+    "procedure", "protected", "raise", "range", "record", "rem", "renames",
+    "requeue", "return", "reverse", "select", "separate", "some", "subtype",
+    "synchronized", "tagged", "task", "terminate", "then", "type", "until",
+    "use", "when", "while", "with", "xor",
+};
+
+// Number of the reserved word starting at 1, 0 if it is none:
+constexpr int keyword(std::string_view word) {
+    auto it = std::lower_bound(keywords.begin(), keywords.end(), word);
+    return (it != keywords.end() && *it == word) ? it - keywords.begin() + 1 : 0;
+}
+
+#endif // KEYWORDS_HPP
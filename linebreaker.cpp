@@ -0,0 +1,205 @@
+#include "linebreaker.hpp"
+#include "utils.hpp"
+
+using namespace std;
+
+// Size of what is known not to fit:
+static const long infinity = 0xffff;
+
+void LineBreaker::wrap(string_view line, const pmr::vector<Mark>& marks,
+                       pmr::vector<pmr::string>& lines)
+{
+    const size_t indent = line.find_first_not_of(' ');
+    if (indent == string_view::npos) {
+        lines.emplace_back(line);
+        return;
+    }
+    out = &lines;
+    buffer.clear();
+    scanStack.clear();
+    frames.clear();
+    first = 0;
+    leftTotal = rightTotal = 0;
+    space = width;
+    current.clear();
+
+    text(line.substr(0, indent));
+    begin(continuation);
+    size_t pos = indent;
+    int depth = 0;
+    for (const auto& mark: marks) {
+        if (mark.pos < pos || mark.pos > line.size())
+            continue;
+        if (mark.pos > pos)
+            text(line.substr(pos, mark.pos - pos));
+        pos = mark.pos;
+        switch (mark.kind) {
+        case Mark::Kind::OPEN:
+            begin(0);
+            ++depth;
+            break;
+        case Mark::Kind::CLOSE:
+            // Parentheses opened on an earlier line are left alone:
+            if (depth) {
+                end();
+                --depth;
+            }
+            break;
+        case Mark::Kind::BREAK:
+            {
+                const long blank = (pos < line.size() && line[pos] == ' ');
+                brk(blank);
+                pos += blank;
+                break;
+            }
+        } // end switch //
+    } // end for //
+    if (pos < line.size())
+        text(line.substr(pos));
+    while (depth--)
+        end();
+    end();
+    eof();
+    lines.emplace_back(current);
+    out = nullptr;
+}
+
+void LineBreaker::begin(long offset)
+{
+    if (scanStack.empty())
+        leftTotal = rightTotal = 1;
+    scanStack.push_back(first + buffer.size());
+    buffer.push_back(Entry{Kind::BEGIN, {}, 0, offset, -rightTotal});
+}
+
+void LineBreaker::end()
+{
+    if (scanStack.empty()) {
+        print(Entry{Kind::END, {}, 0, 0, 0});
+        return;
+    }
+    scanStack.push_back(first + buffer.size());
+    buffer.push_back(Entry{Kind::END, {}, 0, 0, -1});
+}
+
+void LineBreaker::brk(long blank)
+{
+    if (scanStack.empty())
+        leftTotal = rightTotal = 1;
+    else
+        checkStack();
+    scanStack.push_back(first + buffer.size());
+    buffer.push_back(Entry{Kind::BREAK, {}, blank, 0, -rightTotal});
+    rightTotal += blank;
+}
+
+void LineBreaker::text(string_view s)
+{
+    const long size = utf8 ? text_width(s) : s.size();
+    if (scanStack.empty()) {
+        print(Entry{Kind::TEXT, s, 0, 0, size});
+        return;
+    }
+    buffer.push_back(Entry{Kind::TEXT, s, 0, 0, size});
+    rightTotal += size;
+    checkStream();
+}
+
+void LineBreaker::eof()
+{
+    if (!scanStack.empty()) {
+        checkStack();
+        advanceLeft();
+    }
+}
+
+// Print from the left, while the pending text is wider than the line:
+void LineBreaker::checkStream()
+{
+    while (rightTotal - leftTotal > space && !buffer.empty()) {
+        if (!scanStack.empty() && scanStack.front() == first) {
+            buffer.front().size = infinity;
+            scanStack.pop_front();
+        }
+        const size_t before = first;
+        advanceLeft();
+        if (first == before)
+            break;
+    } // end while //
+}
+
+// Fill in the sizes of the last break and of the groups closed since:
+void LineBreaker::checkStack()
+{
+    int depth = 0;
+    while (!scanStack.empty()) {
+        Entry& e = buffer[scanStack.back() - first];
+        if (e.kind == Kind::BEGIN) {
+            if (depth == 0)
+                break;
+            scanStack.pop_back();
+            e.size += rightTotal;
+            --depth;
+        } else if (e.kind == Kind::END) {
+            scanStack.pop_back();
+            e.size = 1;
+            ++depth;
+        } else {
+            scanStack.pop_back();
+            e.size += rightTotal;
+            if (depth == 0)
+                break;
+        }
+    } // end while //
+}
+
+void LineBreaker::advanceLeft()
+{
+    while (!buffer.empty() && buffer.front().size >= 0) {
+        const Entry e = buffer.front();
+        buffer.pop_front();
+        ++first;
+        if (e.kind == Kind::TEXT)
+            leftTotal += e.size;
+        else if (e.kind == Kind::BREAK)
+            leftTotal += e.blank;
+        print(e);
+    } // end while //
+}
+
+void LineBreaker::print(const Entry& e)
+{
+    switch (e.kind) {
+    case Kind::BEGIN:
+        if (e.size > space)
+            frames.push_back(Frame{width - space + e.offset, false});
+        else
+            frames.push_back(Frame{0, true});
+        break;
+    case Kind::END:
+        if (!frames.empty())
+            frames.pop_back();
+        break;
+    case Kind::BREAK:
+        if (!frames.empty() && !frames.back().fits && e.size > space) {
+            newLine(frames.back().indent);
+        } else {
+            current.append(e.blank, ' ');
+            space -= e.blank;
+        }
+        break;
+    case Kind::TEXT:
+        current.append(e.text);
+        space -= e.size;
+        break;
+    } // end switch //
+}
+
+void LineBreaker::newLine(long indent)
+{
+    const size_t last = current.find_last_not_of(' ');
+    current.erase(last == string::npos ? 0 : last + 1);
+    out->emplace_back(current);
+    current.assign(indent, ' ');
+    space = width - indent;
+}
@@ -0,0 +1,85 @@
+#ifndef LINEBREAKER_HPP
+#define LINEBREAKER_HPP
+
+#include <cstddef>
+#include <deque>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief LineBreaker Breaks lines that are too wide, after Oppen's pretty
+ *        printer (1980). Parentheses form groups, the marked blanks
+ *        before operators and after commas are the places to break.
+ *        A break is taken only if the text up to the next break does
+ *        not fit. Time is linear in the line length and the lookahead
+ *        is bounded by the width.
+ */
+class LineBreaker
+{
+public:
+    struct Mark {
+        enum class Kind { OPEN, CLOSE, BREAK };
+
+        std::size_t pos;    // Offset in the line
+        Kind kind;          // A BREAK takes the blank at pos, if any
+    };
+
+    // Continuation lines outside of parentheses are indented this more:
+    static const int continuation = 2;
+
+    // Widths count characters, in UTF-8 the bytes of a sequence are one:
+    LineBreaker(std::size_t _width, bool _utf8):
+        width{static_cast<long>(_width)}, utf8{_utf8} {}
+
+    // Append the line to lines, broken at the marks where needed:
+    void wrap(std::string_view line, const std::pmr::vector<Mark>& marks,
+              std::pmr::vector<std::pmr::string>& lines);
+
+private:
+    enum class Kind { TEXT, BREAK, BEGIN, END };
+
+    struct Entry {
+        Kind kind;
+        std::string_view text;  // TEXT only
+        long blank;             // BREAK only
+        long offset;            // BEGIN only
+        long size;              // Negative while not known, width of TEXT
+    };
+
+    struct Frame {
+        long indent;
+        bool fits;
+    };
+
+    void begin(long offset);
+    void end();
+    void brk(long blank);
+    void text(std::string_view s);
+    void eof();
+
+    void checkStream();
+    void checkStack();
+    void advanceLeft();
+    void print(const Entry& e);
+    void newLine(long indent);
+
+    const long width;
+    const bool utf8;
+
+    // Scanning:
+    std::deque<Entry> buffer{};
+    std::size_t first{0};               // Number of buffer.front()
+    std::deque<std::size_t> scanStack{};
+    long leftTotal{0};
+    long rightTotal{0};
+
+    // Printing:
+    long space{0};
+    std::vector<Frame> frames{};
+    std::string current{};
+    std::pmr::vector<std::pmr::string> *out{nullptr};
+};
+
+#endif // LINEBREAKER_HPP
@@ -1,23 +1,64 @@
-#include "formatter.hpp"
-#include "symbol.hpp"
+#include "ada_beautify.hpp"
+#include "batch.hpp"
+#include "fileio.hpp"
+#include "git.hpp"
+#include "outline.hpp"
+#include "sourcemap.hpp"
+#include "split.hpp"
+#include "utils.hpp"
 #include "version.hpp"
+#include "watch.hpp"
 
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
-#include <getopt.h>
+#include "getopt.h"
 
 using namespace std;
 using namespace filesystem;
 
-static istream& open_input(const path &fs) {
-    static ifstream ifs;
-    ifs.open(fs);
-    if (!ifs.is_open())
-        throw runtime_error(string("Unable to open input file \"") +
-                                   fs.filename().string() + "\"");
-    return ifs;
+// Preferred spellings, one per line, "--" starts a comment line:
+static vector<string> read_dictionary(const path &fs) {
+    vector<string> words;
+    istringstream is(read_file(fs));
+    string line;
+    while (getline(is, line)) {
+        istringstream ls(line);
+        string word;
+        if (ls >> word && word.compare(0, 2, "--") != 0)
+            words.push_back(word);
+    } // end while //
+    return words;
+}
+
+// Style settings, comma separated: presets, "key=value" or the name of
+// a file with one setting per line, "--" starts a comment line:
+static void read_style(const string& settings, ada_beautify::Style& style) {
+    istringstream is(settings);
+    string setting;
+    while (getline(is, setting, ',')) {
+        if (setting.find('=') != string::npos || !is_regular_file(setting)) {
+            ada_beautify::set_style(style, setting);
+            continue;
+        }
+        istringstream fs(read_file(path(setting)));
+        string line;
+        while (getline(fs, line)) {
+            trim(line);
+            if (!line.empty() && line.compare(0, 2, "--") != 0)
+                ada_beautify::set_style(style, line);
+        } // end while //
+    } // end while //
 }
 
 static ostream& open_output(const path &fs) {
@@ -31,32 +72,292 @@ static ostream& open_output(const path &fs) {
 
 static void help(const char *name)
 {
-    cerr << "Usage: " << name << " [options]" << endl
+    cerr << "Usage: " << name << " [options] [files...]" << endl
          << "\t-i <input_file>  ... Read input from <input_file>" << endl
          << "\t-o <output_file> ... Write output to <output_file>" << endl
-         << "\t-h ................. Print help (this message)" << endl
-         << "\t-v ................. Verbose" << endl;
+         << "\t-a, --align ........ Line up \":\", \":=\" and \"=>\" in blocks"
+         << endl
+         << "\t-c, --check ........ Only check, if the input is formatted"
+         << endl
+         << "\t-d, --diff ......... Write a unified diff instead" << endl
+         << "\t-D, --dictionary <file>" << endl
+         << "\t                 ... Spell identifiers as in <file>" << endl
+         << "\t-e, --encoding <name>" << endl
+         << "\t                 ... Input is in utf-8 (default) or latin-1"
+         << endl
+         << "\t-g, --changed-since <rev>" << endl
+         << "\t                 ... Also take the Ada sources git reports as"
+         << endl
+         << "\t                     added or modified since <rev>" << endl
+         << "\t-h, --help ......... Print help (this message)" << endl
+         << "\t-j <n> ............. Format <n> files in parallel" << endl
+         << "\t-m, --max-width <n>" << endl
+         << "\t                 ... Break lines longer than <n>" << endl
+         << "\t-M, --memory-limit <MiB>" << endl
+         << "\t                 ... Give up on a file after <MiB> of output"
+         << endl
+         << "\t-n, --first-casing . Spell identifiers as first seen"
+         << endl
+         << "\t-O, --outline <format>" << endl
+         << "\t                 ... List the units instead, <format> is"
+         << endl
+         << "\t                     json (lines) or table (binary)" << endl
+         << "\t-r, --source-map <file>" << endl
+         << "\t                 ... Also write the input line of every output"
+         << endl
+         << "\t                     line to <file>, delta and varint coded"
+         << endl
+         << "\t-s, --split-units <dir>" << endl
+         << "\t                 ... Write every library unit to a file of its"
+         << endl
+         << "\t                     own in <dir> instead" << endl
+         << "\t-S, --style <settings>" << endl
+         << "\t                 ... Lay out as <settings> say, a list of"
+         << endl
+         << "\t                     presets (default, gnat, compact, wide),"
+         << endl
+         << "\t                     key=value and files of these, with the"
+         << endl
+         << "\t                     keys indent, max-indent, keyword-case,"
+         << endl
+         << "\t                     operator-spacing and comment-width"
+         << endl
+         << "\t-t, --token-cache <dir>" << endl
+         << "\t                 ... Keep lexed symbols and the hashes of"
+         << endl
+         << "\t                     formatted units in <dir> for reuse"
+         << endl
+         << "\t-T, --time-limit <ms>" << endl
+         << "\t                 ... Give up on a file after <ms> milliseconds"
+         << endl
+         << "\t-v ................. Verbose" << endl
+         << "\t-V, --verify ....... Fail, if more than layout would change"
+         << endl
+         << "\t-w, --watch <dir>" << endl
+         << "\t                 ... Format sources below <dir> whenever they"
+         << endl
+         << "\t                     are written" << endl
+         << "Files given after the options are formatted in place." << endl;
+}
+
+// Long options and the short option they stand for:
+static const struct {
+    const char *name;
+    const char *option;
+} long_options[] {
+    { "--align",         "-a" },
+    { "--changed-since", "-g" },
+    { "--check",         "-c" },
+    { "--diff",          "-d" },
+    { "--dictionary",    "-D" },
+    { "--encoding",      "-e" },
+    { "--first-casing",  "-n" },
+    { "--help",          "-h" },
+    { "--max-width",     "-m" },
+    { "--memory-limit",  "-M" },
+    { "--outline",       "-O" },
+    { "--source-map",    "-r" },
+    { "--split-units",   "-s" },
+    { "--style",         "-S" },
+    { "--time-limit",    "-T" },
+    { "--token-cache",   "-t" },
+    { "--verify",        "-V" },
+    { "--watch",         "-w" },
+};
+
+// One worker per hardware thread, unless given. Only asked for when
+// many files are formatted, a single one starts quicker without:
+static unsigned worker_count(unsigned workers)
+{
+    return workers ? workers : max(thread::hardware_concurrency(), 1u);
+}
+
+// Replace long options by their short form, getopt() only knows these:
+static vector<char*> short_options(int argc, char *argv[])
+{
+    vector<char*> args(argv, argv + argc);
+    for (auto& arg: args) {
+        if (strcmp(arg, "--") == 0)
+            break;
+        for (const auto& lo: long_options) {
+            if (strcmp(arg, lo.name) == 0) {
+                arg = const_cast<char*>(lo.option);
+                break;
+            }
+        }
+    }
+    args.push_back(nullptr);
+    return args;
+}
+
+// Check one input, report where it differs first:
+static bool check(const string& input, const ada_beautify::Options& options,
+                  string& report)
+{
+    ada_beautify::CheckSink sink(input);
+    ada_beautify::format(input, options, sink);
+    if (sink.matches())
+        return true;
+    report += options.file + ":" + to_string(sink.line()) +
+        ": not formatted\n";
+    return false;
+}
+
+// Write the changes formatting would make to one input:
+static void diff(const string& input, const ada_beautify::Options& options,
+                 ada_beautify::OutputSink& out)
+{
+    ada_beautify::DiffSink sink(input, options.file, out);
+    ada_beautify::format(input, options, sink);
+}
+
+// Write the units of the files, as JSON lines or as one sorted table:
+static int outline(const vector<path>& files, unsigned workers, bool json,
+                   ostream& os)
+{
+    OutlineTable table;
+    mutex table_mutex;
+    Batch batch(workers, [&table, &table_mutex, json] (FileJob& job) {
+        const auto units = ada_beautify::outline(job.input);
+        if (json) {
+            OutlineTable::json(job.file.string(), units, job.report);
+        } else {
+            const lock_guard<mutex> lock(table_mutex);
+            table.add(job.file.string(), units);
+        }
+        return true;
+    });
+    const int result = batch.run(files);
+    if (!json)
+        table.write(os);
+    return result;
+}
+
+// Format one file of a batch, leave formatted files alone:
+static void format_file(FileJob& job, const ada_beautify::Options& options)
+{
+    ada_beautify::BufferSink buffer(job.output);
+    ada_beautify::PassThroughSink sink(job.input, buffer);
+    ada_beautify::format(job.input, options, sink);
+    job.write = !sink.unchanged();
 }
 
-int verbose{0};
+// Format input into one file per library unit in dir, list them in report:
+static void split(const string& input, const ada_beautify::Options& options,
+                  const string& dir, string& report)
+{
+    SplitSink sink(dir);
+    ada_beautify::format(input, options, sink);
+    for (const auto& file: sink.files())
+        report += options.file + ": " + file + "\n";
+}
+
+// Check, diff, split or format the files in place:
+static int batch(const vector<path>& files,
+                 const ada_beautify::Options& options,
+                 unsigned workers, bool check_only, bool diff_only,
+                 const string& split_dir)
+{
+    Batch batch(workers, [&options, check_only, diff_only, &split_dir]
+                (FileJob& job) {
+        ada_beautify::Options file_options{options};
+        file_options.file = job.file.string();
+        file_options.memory = job.memory;
+        if (!split_dir.empty()) {
+            split(job.input, file_options, split_dir, job.report);
+            return true;
+        }
+        if (check_only)
+            return check(job.input, file_options, job.report);
+        if (diff_only) {
+            ada_beautify::BufferSink out(job.report);
+            diff(job.input, file_options, out);
+            return true;
+        }
+        format_file(job, file_options);
+        return true;
+    });
+    return batch.run(files);
+}
+
+/**
+ * @brief UnitsFile Loads formatted units from a file, if there is one, and
+ *        saves them back on the way out.
+ */
+class UnitsFile
+{
+public:
+    UnitsFile(const string& _file, ada_beautify::FormattedUnits& _units):
+        file{_file}, units{_units} { units.load(file); }
+    ~UnitsFile() { units.save(file); }
+
+private:
+    const string file;
+    ada_beautify::FormattedUnits& units;
+};
+
+// Format the sources below dir whenever they are written, until stopped:
+static int watch(const path& dir, const ada_beautify::Options& options,
+                 unsigned workers)
+{
+    // Content hash of every file as last seen or written here. Files
+    // that did not change since, like the ones just formatted, are
+    // skipped:
+    unordered_map<string, uint64_t> seen;
+    mutex seen_mutex;
+    Batch batch(workers, [&options, &seen, &seen_mutex] (FileJob& job) {
+        const string file = job.file.string();
+        const uint64_t hash = content_hash(job.input);
+        {
+            const lock_guard<mutex> lock(seen_mutex);
+            const auto it = seen.find(file);
+            if (it != seen.end() && it->second == hash)
+                return true;
+        }
+        ada_beautify::Options file_options{options};
+        file_options.file = file;
+        file_options.memory = job.memory;
+        format_file(job, file_options);
+        if (job.write)
+            job.report = file + ": formatted\n";
+        const lock_guard<mutex> lock(seen_mutex);
+        seen[file] = job.write ? content_hash(job.output) : hash;
+        return true;
+    });
+    Watcher watcher(dir);
+    if (options.verbose)
+        cerr << "Watching " << dir.string() << endl;
+    watcher.run([&batch] (const vector<path>& files) {
+        batch.run(files);
+        cout.flush();
+    });
+    return EXIT_SUCCESS;
+}
 
 int main(int argc, char *argv[])
 {
     int option{0};
+    ada_beautify::Options options;
     path input_file{""};
     path output_file{""};
+    bool check_only{false};
+    bool diff_only{false};
+    string outline_format{};
+    path watch_dir{""};
+    string since{};
+    string split_dir{};
+    path source_map{""};
+    unsigned workers{0};        // See worker_count()
     bool helped{false};
+    vector<char*> args{short_options(argc, argv)};
 
     try {
         // Get options:
-        while ((option = getopt(argc, argv, "i:o:hv")) >= 0) {
+        while ((option = getopt(argc, args.data(), "i:o:acdD:e:g:hj:m:M:nO:r:s:S:t:T:vVw:")) >= 0) {
             switch (option) {
             case 'i':
                 if (input_file.empty()) {
                     input_file = optarg;
-                    if (!is_regular_file(input_file))
-                        throw runtime_error(string("File not found: \"") +
-                                            input_file.c_str() + "\"");
                     break;
                 } else {
                     help(argv[0]);
@@ -70,11 +371,74 @@ int main(int argc, char *argv[])
                     help(argv[0]);
                     return EXIT_FAILURE;
                 }
+            case 'a':
+                options.align = true;
+                break;
+            case 'c':
+                check_only = true;
+                break;
+            case 'd':
+                diff_only = true;
+                break;
+            case 'D':
+                options.dictionary = read_dictionary(optarg);
+                break;
+            case 'e':
+                if (strcmp(optarg, "utf-8") == 0)
+                    options.encoding = ada_beautify::Encoding::UTF8;
+                else if (strcmp(optarg, "latin-1") == 0)
+                    options.encoding = ada_beautify::Encoding::LATIN1;
+                else
+                    throw runtime_error(string("Unknown encoding \"") +
+                                        optarg + "\"");
+                break;
+            case 'g':
+                since = optarg;
+                break;
             case 'h':
                 help(argv[0]);
                 return EXIT_SUCCESS;
+            case 'j':
+                workers = max(atoi(optarg), 1);
+                break;
+            case 'm':
+                options.max_width = strtoul(optarg, nullptr, 10);
+                break;
+            case 'M':
+                options.memory_limit = strtoull(optarg, nullptr, 10) << 20;
+                break;
+            case 'n':
+                options.first_casing = true;
+                break;
+            case 'O':
+                outline_format = optarg;
+                if (outline_format != "json" && outline_format != "table")
+                    throw runtime_error("Unknown outline format \"" +
+                                        outline_format + "\"");
+                break;
+            case 'r':
+                source_map = optarg;
+                break;
+            case 's':
+                split_dir = optarg;
+                break;
+            case 'S':
+                read_style(optarg, options.style);
+                break;
+            case 't':
+                options.token_cache = optarg;
+                break;
+            case 'T':
+                options.time_limit = strtoul(optarg, nullptr, 10);
+                break;
             case 'v':
-                ++ verbose;
+                ++ options.verbose;
+                break;
+            case 'V':
+                options.verify = true;
+                break;
+            case 'w':
+                watch_dir = optarg;
                 break;
             default:
                 if (helped) {
@@ -86,23 +450,123 @@ int main(int argc, char *argv[])
             } // end switch //
         } // end while //
 
-        if (verbose)
+        if (options.verbose)
             cerr << APP_NAME << " " << APP_VERSION << endl;
 
-        istream& is{input_file.empty() ? cin : open_input(input_file)};
-        ostream& os{output_file.empty() ? cout : open_output(output_file)};
+        // Units formatted before are copied. Watching keeps them while
+        // it runs, the token cache from run to run:
+        ada_beautify::FormattedUnits units;
+        if (!watch_dir.empty() || !options.token_cache.empty())
+            options.formatted = &units;
+        optional<UnitsFile> units_file;
+        if (!options.token_cache.empty())
+            units_file.emplace(
+                (path(options.token_cache) / "formatted-units").string(),
+                units);
+
+        // Checking and writing a diff exclude each other:
+        if (check_only && diff_only) {
+            help(argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        // A source map goes with the formatted text of one input:
+        if (!source_map.empty() &&
+            (!watch_dir.empty() || optind < argc || !since.empty() ||
+             !outline_format.empty() || !split_dir.empty() || check_only ||
+             diff_only)) {
+            help(argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        if (!watch_dir.empty()) {
+            if (optind < argc || !input_file.empty() ||
+                !output_file.empty()) {
+                help(argv[0]);
+                return EXIT_FAILURE;
+            }
+            return watch(watch_dir, options, worker_count(workers));
+        }
+
+        // Batch mode:
+        if (optind < argc || !since.empty()) {
+            if (!input_file.empty() || !output_file.empty()) {
+                help(argv[0]);
+                return EXIT_FAILURE;
+            }
+            vector<path> files(argv + optind, argv + argc);
+            if (!since.empty()) {
+                const vector<path> changed{changed_since(since)};
+                if (options.verbose)
+                    cerr << changed.size() << " files changed since "
+                         << since << endl;
+                files.insert(files.end(), changed.begin(), changed.end());
+            }
+            // A file given twice, or given and changed, is one job:
+            unordered_set<path> seen;
+            erase_if(files, [&seen] (const path& file) {
+                error_code ec;
+                const path key{weakly_canonical(file, ec)};
+                return !seen.insert(ec ? file : key).second;
+            });
+            if (!outline_format.empty())
+                return outline(files, worker_count(workers),
+                               outline_format == "json", cout);
+            return batch(files, options, worker_count(workers), check_only,
+                         diff_only, split_dir);
+        }
+
+        // A single input is read and written without iostream, for a
+        // quick start:
+        const string input{read_file(input_file)};
+        options.file = input_file.empty() ? "<stdin>" : input_file.string();
+
+        if (!outline_format.empty()) {
+            ostream& os{output_file.empty() ? cout
+                                            : open_output(output_file)};
+            const auto units = ada_beautify::outline(input);
+            if (outline_format == "json") {
+                string json;
+                OutlineTable::json(options.file, units, json);
+                os << json;
+            } else {
+                OutlineTable table;
+                table.add(options.file, units);
+                table.write(os);
+            }
+            return EXIT_SUCCESS;
+        }
+
+        if (!split_dir.empty()) {
+            string report;
+            split(input, options, split_dir, report);
+            if (options.verbose)
+                cerr << report;
+            return EXIT_SUCCESS;
+        }
 
-        Symbol::open(is);
+        if (check_only) {
+            string report;
+            const bool passed{check(input, options, report)};
+            cout << report;
+            return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
 
-        Formatter formatter;
-        Symbol::Ref sym;
-        do {
-            sym = Symbol::get();
-            if (verbose > 1)
-                cerr << "Insert " << sym->to_str() << endl;
-            formatter.add(sym);
-        } while (sym != Symbol::Kind::END);
-        formatter.print(os);
+        FdSink out(output_file);
+        if (diff_only) {
+            diff(input, options, out);
+        } else if (!source_map.empty()) {
+            ofstream map(source_map, ios::binary);
+            if (!map.is_open())
+                throw runtime_error(string("Unable to open source map \"") +
+                                    source_map.filename().string() + "\"");
+            SourceMapSink mapped(out, map);
+            ada_beautify::PassThroughSink sink(input, mapped);
+            ada_beautify::format(input, options, sink);
+        } else {
+            ada_beautify::PassThroughSink sink(input, out);
+            ada_beautify::format(input, options, sink);
+        }
     }
     catch(const exception &ex) {
         cerr << "Fatal error: " << ex.what() << endl;
@@ -0,0 +1,101 @@
+#include "names.hpp"
+#include "keywords.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+static inline char fold(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+// FNV-1a over the case folded name:
+static uint64_t fold_hash(string_view s)
+{
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (const char c: s) {
+        h ^= static_cast<unsigned char>(fold(c));
+        h *= 0x100000001b3ull;
+    } // end for //
+    return h;
+}
+
+static bool fold_equal(string_view a, string_view b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (fold(a[i]) != fold(b[i]))
+            return false;
+    } // end for //
+    return true;
+}
+
+uint32_t NameTable::find(string_view spelling, uint64_t hash) const
+{
+    if (slots.empty())
+        return 0;
+    const size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask; slots[i]; i = (i + 1) & mask) {
+        const Entry& e = entries[slots[i] - 1];
+        if (e.hash == hash && fold_equal(*e.spellings.front(), spelling))
+            return slots[i];
+    } // end for //
+    return 0;
+}
+
+// Keep the table at most half full:
+void NameTable::grow()
+{
+    pmr::vector<uint32_t> old(max<size_t>(64, slots.size() * 2), 0, memory);
+    old.swap(slots);
+    const size_t mask = slots.size() - 1;
+    for (uint32_t id = 1; id <= entries.size(); ++id) {
+        size_t i = entries[id - 1].hash & mask;
+        while (slots[i])
+            i = (i + 1) & mask;
+        slots[i] = id;
+    } // end for //
+}
+
+NameTable::Name NameTable::intern(string_view spelling)
+{
+    const uint64_t hash = fold_hash(spelling);
+    uint32_t id = find(spelling, hash);
+    if (id) {
+        // Another spelling of a known name?
+        Entry& e = entries[id - 1];
+        for (const pmr::string *s: e.spellings) {
+            if (*s == spelling)
+                return Name{id, s};
+        } // end for //
+        strings.emplace_back(spelling);
+        e.spellings.push_back(&strings.back());
+        return Name{id, &strings.back()};
+    }
+    if (2 * (entries.size() + 1) > slots.size())
+        grow();
+    strings.emplace_back(spelling);
+    const pmr::string *s = &strings.back();
+    string folded(spelling);
+    for (auto& c: folded)
+        c = fold(c);
+    entries.push_back(Entry{hash, s,
+                            pmr::vector<const pmr::string*>({s}, memory),
+                            false, keyword(folded) != 0});
+    id = entries.size();
+    size_t i = hash & (slots.size() - 1);
+    while (slots[i])
+        i = (i + 1) & (slots.size() - 1);
+    slots[i] = id;
+    return Name{id, s};
+}
+
+void NameTable::prefer(string_view spelling)
+{
+    const Name name = intern(spelling);
+    Entry& e = entries[name.id - 1];
+    e.canonical = name.spelling;
+    e.preferred = true;
+}
@@ -0,0 +1,66 @@
+#ifndef NAMES_HPP
+#define NAMES_HPP
+
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief NameTable Interns identifiers. Spellings that differ in case only
+ *        share one id, each spelling is stored once and stays put while
+ *        the table lives.
+ */
+class NameTable
+{
+public:
+    struct Name {
+        std::uint32_t id;               // From 1 on
+        const std::pmr::string *spelling;   // As written
+    };
+
+    // The table and the spellings come from memory:
+    NameTable(std::pmr::memory_resource *_memory =
+              std::pmr::get_default_resource()):
+        memory{_memory} {}
+    NameTable(const NameTable&) = delete;
+
+    Name intern(std::string_view spelling);
+    // Make spelling the one canonical() returns for its name:
+    void prefer(std::string_view spelling);
+
+    // The preferred spelling, else the first one seen:
+    const std::pmr::string& canonical(std::uint32_t id) const {
+        return *entries[id - 1].canonical;
+    }
+    // Reserved words and names without a preferred spelling are kept:
+    bool preferred(std::uint32_t id) const {
+        return entries[id - 1].preferred;
+    }
+    bool reserved(std::uint32_t id) const {
+        return entries[id - 1].reserved;
+    }
+
+    std::size_t size() const { return entries.size(); }
+
+private:
+    struct Entry {
+        std::uint64_t hash;
+        const std::pmr::string *canonical;
+        std::pmr::vector<const std::pmr::string*> spellings;
+        bool preferred;
+        bool reserved;
+    };
+
+    std::uint32_t find(std::string_view spelling, std::uint64_t hash) const;
+    void grow();
+
+    std::pmr::memory_resource *memory;
+    std::pmr::deque<std::pmr::string> strings{memory};
+    std::pmr::vector<Entry> entries{memory};
+    std::pmr::vector<std::uint32_t> slots{memory};  // Entry id, 0 if free
+};
+
+#endif // NAMES_HPP
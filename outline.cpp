@@ -0,0 +1,104 @@
+#include "outline.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+using namespace std;
+
+static const char magic[8] {'A', 'D', 'A', 'B', 'O', 'U', 'T', '\0'};
+
+// The layout is part of the file format:
+static_assert(sizeof(OutlineTable::Header) == 24);
+static_assert(sizeof(OutlineTable::Record) == 36);
+
+// Append s as the contents of a JSON string:
+static void escape(string_view s, string& out)
+{
+    static const char hex[] = "0123456789abcdef";
+    for (const char c: s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += "\\u00";
+            out += hex[(c >> 4) & 0xf];
+            out += hex[c & 0xf];
+        } else {
+            out += c;
+        }
+    } // end for //
+}
+
+void OutlineTable::json(string_view file,
+                        const vector<ada_beautify::Unit>& units, string& out)
+{
+    for (const auto& unit: units) {
+        out += "{\"file\":\"";
+        escape(file, out);
+        out += "\",\"name\":\"";
+        escape(unit.name, out);
+        out += "\",\"kind\":\"" + unit.kind +
+            "\",\"depth\":" + to_string(unit.depth) +
+            ",\"line\":" + to_string(unit.line) +
+            ",\"end_line\":" + to_string(unit.end_line) + "}\n";
+    } // end for //
+}
+
+void OutlineTable::add(string_view file,
+                       const vector<ada_beautify::Unit>& units)
+{
+    const uint32_t file_offset = pooled(file);
+    for (const auto& unit: units) {
+        const uint32_t name = pool.size();
+        pool += unit.name;
+        records.push_back(Record{
+                name, static_cast<uint32_t>(unit.name.size()),
+                file_offset, static_cast<uint32_t>(file.size()),
+                pooled(unit.kind), static_cast<uint32_t>(unit.kind.size()),
+                static_cast<uint32_t>(unit.depth),
+                static_cast<uint32_t>(unit.line),
+                static_cast<uint32_t>(unit.end_line)});
+    } // end for //
+}
+
+void OutlineTable::write(ostream& os)
+{
+    const auto text = [this] (uint32_t offset, uint32_t length) {
+        return string_view(pool).substr(offset, length);
+    };
+    const auto less_name = [] (char a, char b) {
+        return tolower(static_cast<unsigned char>(a)) <
+            tolower(static_cast<unsigned char>(b));
+    };
+    stable_sort(records.begin(), records.end(),
+                [&] (const Record& a, const Record& b) {
+        const string_view na = text(a.name, a.name_length);
+        const string_view nb = text(b.name, b.name_length);
+        if (lexicographical_compare(na.begin(), na.end(),
+                                    nb.begin(), nb.end(), less_name))
+            return true;
+        if (lexicographical_compare(nb.begin(), nb.end(),
+                                    na.begin(), na.end(), less_name))
+            return false;
+        const string_view fa = text(a.file, a.file_length);
+        const string_view fb = text(b.file, b.file_length);
+        return fa != fb ? fa < fb : a.line < b.line;
+    });
+    Header header{};
+    copy(begin(magic), end(magic), header.magic);
+    header.version = version;
+    header.count = records.size();
+    header.pool_size = pool.size();
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    os.write(reinterpret_cast<const char*>(records.data()),
+             records.size() * sizeof(Record));
+    os.write(pool.data(), pool.size());
+}
+
+uint32_t OutlineTable::pooled(string_view s)
+{
+    const auto [it, added] = offsets.try_emplace(string(s), pool.size());
+    if (added)
+        pool += s;
+    return it->second;
+}
@@ -0,0 +1,63 @@
+#ifndef OUTLINE_HPP
+#define OUTLINE_HPP
+
+#include "ada_beautify.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief OutlineTable The units of many files as one binary table, sorted
+ *        by name ignoring case, then by file and line, so that a reader
+ *        finds a name by binary search over the mapped file. Numbers are
+ *        in native byte order.
+ *
+ *        Layout: Header, Record[count], string pool of pool_size bytes.
+ */
+class OutlineTable
+{
+public:
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t count;
+        std::uint64_t pool_size;
+    };
+
+    struct Record {
+        std::uint32_t name;         // Strings in the pool
+        std::uint32_t name_length;
+        std::uint32_t file;
+        std::uint32_t file_length;
+        std::uint32_t kind;
+        std::uint32_t kind_length;
+        std::uint32_t depth;
+        std::uint32_t line;
+        std::uint32_t end_line;
+    };
+
+    static const std::uint32_t version = 1;
+
+    // The units as JSON lines, one object per unit:
+    static void json(std::string_view file,
+                     const std::vector<ada_beautify::Unit>& units,
+                     std::string& out);
+
+    void add(std::string_view file,
+             const std::vector<ada_beautify::Unit>& units);
+    void write(std::ostream& os);
+
+private:
+    std::uint32_t pooled(std::string_view s);
+
+    std::vector<Record> records{};
+    std::string pool{};
+    // File names and kinds are stored once:
+    std::unordered_map<std::string, std::uint32_t> offsets{};
+};
+
+#endif // OUTLINE_HPP
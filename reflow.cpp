@@ -0,0 +1,138 @@
+#include "reflow.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+using namespace std;
+
+void CommentReflow::add(string_view line, int line_no)
+{
+    text.append(line);
+    text.push_back('\n');
+    last = line_no;
+}
+
+CommentReflow::Kind CommentReflow::classify(string_view line)
+{
+    if (line.starts_with("[P2Ada]"))
+        return Kind::MARKER;
+    const unsigned char c = line[0];
+    // "- item", "1. item", "2) item", "a) item":
+    size_t i = 0;
+    while (i < line.size() && isdigit(static_cast<unsigned char>(line[i])))
+        ++i;
+    if (((c == '-' || c == '*' || c == '+') && line.size() > 1 &&
+         line[1] == ' ') ||
+        (i && i + 1 < line.size() && (line[i] == '.' || line[i] == ')') &&
+         line[i + 1] == ' ') ||
+        (isalpha(c) && line.size() > 2 && line[1] == ')' && line[2] == ' '))
+        return Kind::ITEM;
+    // Rulers, tables and commented out code:
+    if (!(isalnum(c) || c >= 0x80 || c == '(' || c == '"' || c == '\'' ||
+          c == '`') || line.back() == ';' ||
+        line.find(":=") != string_view::npos ||
+        line.find("=>") != string_view::npos)
+        return Kind::CODE;
+    return Kind::PROSE;
+}
+
+size_t CommentReflow::measure(string_view s) const
+{
+    return utf8 ? text_width(s) : s.size();
+}
+
+void CommentReflow::put(string_view line, int line_no)
+{
+    out->emplace_back(*prefix);
+    out->back().append("--  ").append(line);
+    out_origins->push_back(line_no);
+}
+
+void CommentReflow::fill(string_view words, size_t room, int line)
+{
+    current.clear();
+    size_t column = 0;
+    bool fresh = true;      // No word on the current line yet
+    int first = line;       // Input line of the first word on it
+    size_t pos = 0;
+    for (;;) {
+        const size_t begin = words.find_first_not_of(" \n", pos);
+        if (begin == string_view::npos)
+            break;
+        line += count(words.begin() + pos, words.begin() + begin, '\n');
+        const size_t end = min(words.find_first_of(" \n", begin), words.size());
+        const string_view word = words.substr(begin, end - begin);
+        const size_t size = measure(word);
+        if (!fresh && column + 1 + size > room) {
+            put(current, first);
+            current.clear();
+            column = 0;
+            fresh = true;
+        }
+        if (fresh) {
+            first = line;
+        } else {
+            current.push_back(' ');
+            ++column;
+        }
+        current.append(word);
+        column += size;
+        fresh = false;
+        pos = end;
+    } // end for //
+    if (!fresh)
+        put(current, first);
+}
+
+void CommentReflow::flush(const string& indent,
+                          pmr::vector<pmr::string>& lines,
+                          pmr::vector<int>& origins)
+{
+    prefix = &indent;
+    out = &lines;
+    out_origins = &origins;
+    // The run ends on line last:
+    int line = last + 1 - count(text.begin(), text.end(), '\n');
+    // Room for the text after the indent and "--  ":
+    const size_t used = indent.size() + 4;
+    const size_t room = width > used ? width - used : 1;
+    string_view rest = text;
+    while (!rest.empty()) {
+        size_t end = rest.find('\n');
+        const Kind kind = classify(rest.substr(0, end));
+        if (kind == Kind::CODE) {
+            put(rest.substr(0, end), line++);
+            rest.remove_prefix(end + 1);
+            continue;
+        }
+        // The paragraph goes on up to the next line of another kind, or
+        // up to a line ending in ':'. A note of P2Ada is a line alone:
+        bool wide = measure(rest.substr(0, end)) > room;
+        size_t size = end + 1;
+        while (kind != Kind::MARKER && rest[size - 2] != ':' &&
+               size < rest.size()) {
+            end = rest.find('\n', size);
+            const string_view line = rest.substr(size, end - size);
+            if (classify(line) != Kind::PROSE)
+                break;
+            wide = wide || measure(line) > room;
+            size = end + 1;
+        } // end while //
+        const string_view paragraph = rest.substr(0, size);
+        if (wide) {
+            fill(paragraph, room, line);
+            line += count(paragraph.begin(), paragraph.end(), '\n');
+        } else {
+            for (size_t pos = 0; pos < size; pos = end + 1) {
+                end = paragraph.find('\n', pos);
+                put(paragraph.substr(pos, end - pos), line++);
+            } // end for //
+        }
+        rest.remove_prefix(size);
+    } // end while //
+    text.clear();
+    out = nullptr;
+    out_origins = nullptr;
+    prefix = nullptr;
+}
@@ -0,0 +1,59 @@
+#ifndef REFLOW_HPP
+#define REFLOW_HPP
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief CommentReflow Fills runs of comment lines into a width, greedily,
+ *        like fmt does. A run is split into paragraphs: "[P2Ada]" notes
+ *        and list items start one, code-like lines stay as they are.
+ *        Only paragraphs with a line wider than the width are filled.
+ *        The run is kept in one buffer and filled in one pass over it,
+ *        so no word is ever copied on its own.
+ */
+class CommentReflow
+{
+public:
+    // Widths count characters, in UTF-8 the bytes of a sequence are one:
+    CommentReflow(std::size_t _width, bool _utf8):
+        width{_width}, utf8{_utf8} {}
+
+    // Add the text of the comment on line, without the "--":
+    void add(std::string_view text, int line);
+    // True, if text on line continues the run added so far:
+    bool continues(int line) const { return !empty() && line == last + 1; }
+    bool empty() const { return text.empty(); }
+    // Append the run as comment lines behind indent, and start anew.
+    // The input line of each goes to origins, for filled lines the one
+    // of their first word:
+    void flush(const std::string& indent,
+               std::pmr::vector<std::pmr::string>& lines,
+               std::pmr::vector<int>& origins);
+
+private:
+    enum class Kind { PROSE, MARKER, ITEM, CODE };
+
+    static Kind classify(std::string_view line);
+    std::size_t measure(std::string_view s) const;
+    // Fill the words of text from input line on into lines of at most
+    // room characters:
+    void fill(std::string_view text, std::size_t room, int line);
+    void put(std::string_view line, int line_no);
+
+    const std::size_t width;
+    const bool utf8;
+    std::string text{};         // Lines of the run, each ending in '\n'
+    int last{0};                // Line of the last comment added
+
+    // While flushing:
+    const std::string *prefix{nullptr};
+    std::pmr::vector<std::pmr::string> *out{nullptr};
+    std::pmr::vector<int> *out_origins{nullptr};
+    std::string current{};
+};
+
+#endif // REFLOW_HPP
@@ -1,12 +1,17 @@
 #ifndef SCANNER_HPP
 #define SCANNER_HPP
 
-#include <iostream>
+#include "utils.hpp"
+
+#include <cstdio>
+#include <string_view>
 
 class scanner
 {
 public:
-    scanner(std::istream &_is): is{_is}
+    // Columns count characters, in UTF-8 the bytes of a sequence are one:
+    scanner(std::string_view _text, bool _utf8 = true):
+        text{_text}, lead_mask{_utf8 ? 0xC0 : 0x00}
     {
         get_ch();
     }
@@ -17,15 +22,75 @@ public:
     {
         if (eof())
             return;
-        cur_ch = is.get();
-        if (eof())
-            return;
+        // Line and column always describe the position of cur_ch:
         if (cur_ch == '\n') {
             cur_line += 1;
             cur_col = 0;
-        } else {
-            cur_col += 1;
         }
+        if (pos >= text.size()) {
+            cur_ch = EOF;
+            return;
+        }
+        cur_ch = static_cast<unsigned char>(text[pos++]);
+        cur_col += (cur_ch & lead_mask) != 0x80;
+    }
+
+    // Move cur_ch on to offset end in one step. The text skipped, cur_ch
+    // included, must not hold a '\n':
+    void advance_to(std::size_t end)
+    {
+        if (eof() || end <= position())
+            return;
+        if (end >= text.size()) {
+            cur_col += width(text.substr(pos));
+            pos = text.size();
+            cur_ch = EOF;
+            return;
+        }
+        cur_col += width(text.substr(pos, end + 1 - pos));
+        pos = end + 1;
+        cur_ch = static_cast<unsigned char>(text[end]);
+    }
+
+    // Go on at offset, the start of line:
+    void seek(std::size_t offset, int line)
+    {
+        pos = std::min(offset, text.size());
+        cur_ch = 0x00;
+        cur_line = line;
+        cur_col = 0;
+        get_ch();
+    }
+
+    // Offset of the first of chars from cur_ch on, the text size if none:
+    std::size_t find_first_of(std::string_view chars) const
+    {
+        return std::min(text.find_first_of(chars, position()), text.size());
+    }
+
+    // Offset of the first byte from cur_ch on, that is no token char:
+    std::size_t token_end() const
+    {
+        const unsigned char *p =
+            reinterpret_cast<const unsigned char*>(text.data());
+        const bool *table = tokenchars.data();
+        const std::size_t size = text.size();
+        std::size_t end = position();
+        while (end < size && table[p[end]])
+            ++end;
+        return end;
+    }
+
+    // True, if cur_ch is not the first byte of a character:
+    bool continuation() const { return (cur_ch & lead_mask) == 0x80; }
+
+    // Offset of cur_ch in the text:
+    std::size_t position() const { return eof() ? text.size() : pos - 1; }
+
+    // Text from offset start up to cur_ch:
+    std::string_view text_from(std::size_t start) const
+    {
+        return text.substr(start, position() - start);
     }
 
     void skip_whitespace()
@@ -39,7 +104,14 @@ public:
     int cur_col{0};
 
 private:
-    std::istream &is;
+    int width(std::string_view s) const
+    {
+        return lead_mask ? text_width(s) : s.size();
+    }
+
+    std::string_view text;
+    std::size_t pos{0};
+    const int lead_mask;        // 0 in Latin-1, every byte leads
 };
 
 #endif // SCANNER_HPP
@@ -1,7 +1,11 @@
 #ifndef SCOPE_HPP
 #define SCOPE_HPP
 
+#include "linebreaker.hpp"
+
+#include <memory_resource>
 #include <sstream>
+#include <string>
 #include <vector>
 
 class Document;
@@ -9,21 +13,34 @@ class Document;
 class Scope
 {
 public:
-    Scope(Document& _doc): doc{_doc} {}
+    // Everything of the scope comes from the memory of the document:
+    Scope(Document& _doc, std::pmr::memory_resource *_memory):
+        doc{_doc}, lineBuffer{std::ios::in | std::ios::out, _memory},
+        end_id{_memory}, comments{_memory}, content{_memory},
+        comment_origins{_memory}, content_origins{_memory}, marks{_memory} {}
+
+    // Without copying the buffer, str() would make long lines quadratic:
+    bool lineEmpty() { return lineBuffer.tellp() <= 0; }
 
     Document& doc;
-    std::stringstream lineBuffer{};
+    std::basic_stringstream<char, std::char_traits<char>,
+                            std::pmr::polymorphic_allocator<char>> lineBuffer;
     bool end{false};
     bool is{false};
     bool dot{false};
     bool loop{false};
     bool exit{false};
     bool type{false};
-    std::string end_id{};
+    std::pmr::string end_id;
     int para{0};
+    int origin{0};      // Input line of the line under construction
 
-    std::vector<std::string> comments{};
-    std::vector<std::string> content{};
+    std::pmr::vector<std::pmr::string> comments;
+    std::pmr::vector<std::pmr::string> content;
+    // The input line each of comments and content came from:
+    std::pmr::vector<int> comment_origins;
+    std::pmr::vector<int> content_origins;
+    std::pmr::vector<LineBreaker::Mark> marks;  // In lineBuffer
 };
 
 #endif // SCOPE_HPP
@@ -0,0 +1,70 @@
+#include "sourcemap.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+
+using namespace std;
+
+static constexpr string_view magic{"ADAMAP\x01\x00", 8};
+static constexpr size_t buffer_size{64 * 1024};
+
+SourceMapSink::SourceMapSink(ada_beautify::OutputSink& _out, ostream& _map):
+    out{_out}, map{_map}
+{
+    buffer.reserve(buffer_size);
+    buffer.append(magic);
+}
+
+void SourceMapSink::origin(int line)
+{
+    const int32_t delta = line - previous;
+    previous = line;
+    uint32_t n = (static_cast<uint32_t>(delta) << 1) ^
+        static_cast<uint32_t>(delta >> 31);
+    while (n >= 0x80) {
+        buffer.push_back(static_cast<char>(n | 0x80));
+        n >>= 7;
+    }
+    buffer.push_back(static_cast<char>(n));
+    if (buffer.size() >= buffer_size)
+        flush();
+}
+
+void SourceMapSink::finish()
+{
+    flush();
+    map.flush();
+    out.finish();
+}
+
+void SourceMapSink::flush()
+{
+    map.write(buffer.data(), buffer.size());
+    buffer.clear();
+}
+
+vector<int> SourceMapSink::read(string_view map)
+{
+    if (!map.starts_with(magic))
+        throw runtime_error("No source map");
+    vector<int> lines;
+    int line = 0;
+    uint32_t n = 0;
+    int shift = 0;
+    for (size_t i = magic.size(); i < map.size(); ++i) {
+        const unsigned char c = map[i];
+        if (shift > 28)
+            throw runtime_error("Broken source map");
+        n |= static_cast<uint32_t>(c & 0x7F) << shift;
+        shift += 7;
+        if (c & 0x80)
+            continue;
+        line += static_cast<int32_t>((n >> 1) ^ -(n & 1));
+        lines.push_back(line);
+        n = 0;
+        shift = 0;
+    } // end for //
+    if (shift)
+        throw runtime_error("Broken source map");
+    return lines;
+}
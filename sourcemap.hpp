@@ -0,0 +1,50 @@
+#ifndef SOURCEMAP_HPP
+#define SOURCEMAP_HPP
+
+#include "ada_beautify.hpp"
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief SourceMapSink Forwards the formatted text to another sink and
+ *        writes the input line of every output line to a stream, while
+ *        the text is produced. The map starts with "ADAMAP" and the
+ *        version, 1, as a 16 bit number, low byte first. Then comes
+ *        one number per output line, the difference of its input line
+ *        to the one of the line before (the first to line 0). Numbers
+ *        are zigzag encoded, so small steps back stay small too, and
+ *        written as LEB128 varints, 7 bits per byte, low bits first.
+ *        Most lines take one byte this way.
+ */
+class SourceMapSink: public ada_beautify::OutputSink
+{
+public:
+    SourceMapSink(ada_beautify::OutputSink& _out, std::ostream& _map);
+
+    virtual void write(std::string_view text) { out.write(text); }
+    virtual void diagnostic(const ada_beautify::Diagnostic& diag) {
+        out.diagnostic(diag);
+    }
+    virtual void unit(int line) { out.unit(line); }
+    virtual void origin(int line);
+    virtual bool done() const { return out.done(); }
+    virtual void finish();
+
+    // The input line of every output line in map, throws a runtime_error,
+    // if map is none:
+    static std::vector<int> read(std::string_view map);
+
+private:
+    void flush();
+
+    ada_beautify::OutputSink& out;
+    std::ostream& map;
+    std::string buffer{};
+    int previous{0};
+};
+
+#endif // SOURCEMAP_HPP
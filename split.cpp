@@ -0,0 +1,127 @@
+#include "split.hpp"
+#include "symbol.hpp"
+#include "syntax.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+using namespace filesystem;
+
+/**
+ * @brief ParentSource Passes on the symbols of another source and picks
+ *        the parent name of a subunit from "separate (Parent)" on the way.
+ */
+class ParentSource: public SymbolSource
+{
+public:
+    ParentSource(SymbolSource& _source): source{_source} {}
+
+    virtual const Symbol::Ref get() {
+        const Symbol::Ref sym = source.get();
+        const string_view v = sym->value();
+        switch (state) {
+        case State::SEPARATE:
+            if (sym == Symbol::Kind::IDENTIFIER && v.size() == 8 &&
+                equal(v.begin(), v.end(), "separate",
+                      [] (char a, char b) { return tolower(a) == b; }))
+                state = State::OPEN;
+            break;
+        case State::OPEN:
+            if (sym != Symbol::Kind::NL && sym != Symbol::Kind::COMMENT)
+                state = (v == "(") ? State::NAME : State::SEPARATE;
+            break;
+        case State::NAME:
+            if (v == ")")
+                state = State::DONE;
+            else if (sym == Symbol::Kind::IDENTIFIER || v == ".")
+                parent += v;
+            end = sym->offset();
+            break;
+        case State::DONE:
+            break;
+        } // end switch //
+        return sym;
+    }
+
+    virtual const Symbol::Ref next() const { return source.next(); }
+
+    string parent{};
+    size_t end{0};      // Of "separate (Parent)"
+
+private:
+    enum class State { SEPARATE, OPEN, NAME, DONE };
+
+    SymbolSource& source;
+    State state{State::SEPARATE};
+};
+
+SplitSink::SplitSink(const string& _dir): dir{_dir}
+{
+    create_directories(dir);
+}
+
+void SplitSink::finish()
+{
+    flush();
+    if (carry.find_first_not_of(" \n") == string::npos)
+        return;
+    // Comments after the last unit:
+    if (_files.empty())
+        throw runtime_error("No library unit found");
+    ofstream ofs(_files.back(), ios::binary | ios::app);
+    ofs << carry;
+}
+
+void SplitSink::flush()
+{
+    carry += chunk;
+    chunk.clear();
+    const string name = file_name(carry);
+    if (name.empty())
+        return;
+    const string file = (path(dir) / name).string();
+    if (find(_files.begin(), _files.end(), file) != _files.end())
+        throw runtime_error("Unit given twice: \"" + file + "\"");
+    ofstream ofs(file, ios::binary);
+    if (!ofs.is_open())
+        throw runtime_error("Unable to open output file \"" + file + "\"");
+    // Without the blank lines between the units:
+    ofs << string_view(carry).substr(min(carry.find_first_not_of('\n'),
+                                         carry.size()));
+    _files.push_back(file);
+    carry.clear();
+}
+
+string SplitSink::file_name(string_view text)
+{
+    Lexer lexer(text);
+    ParentSource source(lexer);
+    SyntaxTree tree;
+    tree.parse(source);
+    for (const auto& n: tree.nodes()) {
+        if (n.kind != SyntaxTree::Kind::UNIT || n.parent != 0 ||
+            !n.name_length)
+            continue;
+        // A subunit says "separate (Parent)" before its own name:
+        if (n.offset < source.end)
+            source.parent.clear();
+        string name{source.parent.empty() ? "" : source.parent + "."};
+        name += text.substr(n.name, n.name_length);
+        for (auto& c: name)
+            c = (c == '.') ? '-' : tolower(static_cast<unsigned char>(c));
+        // Children of the predefined units are krunched, like GNAT does:
+        for (const string_view root: {"ada-", "gnat-", "interfaces-",
+                                      "system-"}) {
+            if (name.starts_with(root)) {
+                name.replace(0, root.size(), string(1, root[0]) + "-");
+                break;
+            }
+        } // end for //
+        return name + (n.body || !source.parent.empty() ? ".adb" : ".ads");
+    } // end for //
+    return "";
+}
@@ -0,0 +1,42 @@
+#ifndef SPLIT_HPP
+#define SPLIT_HPP
+
+#include "ada_beautify.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief SplitSink Writes every library unit of the formatted text to a
+ *        file of its own, named the way GNAT looks for it: the unit name
+ *        in lower case, "-" for ".", ".ads" for specs and ".adb" for
+ *        bodies. The context clause before a unit goes with it. Units
+ *        are cut at the unit() calls, so no extra pass over the input is
+ *        made, only the head of each unit is parsed for its name.
+ */
+class SplitSink: public ada_beautify::OutputSink
+{
+public:
+    SplitSink(const std::string& _dir);
+
+    virtual void write(std::string_view text) { chunk.append(text); }
+    virtual void unit(int /*line*/) { flush(); }
+    virtual void finish();
+
+    // Files written so far:
+    const std::vector<std::string>& files() const { return _files; }
+
+    // File name for the first library unit in text, empty if it has none:
+    static std::string file_name(std::string_view text);
+
+private:
+    void flush();
+
+    std::string dir;
+    std::string chunk{};
+    std::string carry{};        // Text before the next unit
+    std::vector<std::string> _files{};
+};
+
+#endif // SPLIT_HPP
@@ -0,0 +1,73 @@
+#include "ada_beautify.hpp"
+
+#include <array>
+#include <charconv>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+namespace ada_beautify {
+
+// Presets by name:
+static const array<pair<string_view, Style>, 4> presets {{
+    { "default", Style{} },
+    { "gnat",    Style{3, 80, true, Casing::LOWER, 0} },
+    { "compact", Style{2, 60, true, Casing::AS_IS, 0} },
+    { "wide",    Style{4, 120, true, Casing::AS_IS, 0} },
+}};
+
+static string_view strip(string_view s)
+{
+    const size_t first = s.find_first_not_of(" \t\r");
+    if (first == string_view::npos)
+        return {};
+    return s.substr(first, s.find_last_not_of(" \t\r") + 1 - first);
+}
+
+static int number(string_view key, string_view value)
+{
+    int n{0};
+    const char *last = value.data() + value.size();
+    const auto [end, ec] = from_chars(value.data(), last, n);
+    if (ec != errc() || end != last || n < 0 || n > 1000)
+        throw runtime_error("Bad value \"" + string(value) + "\" for " +
+                            string(key));
+    return n;
+}
+
+void set_style(Style& style, string_view setting)
+{
+    const size_t equal = setting.find('=');
+    const string_view key = strip(setting.substr(0, equal));
+    if (equal == string_view::npos) {
+        for (const auto& preset: presets) {
+            if (preset.first == key) {
+                style = preset.second;
+                return;
+            }
+        } // end for //
+        throw runtime_error("Unknown style \"" + string(key) + "\"");
+    }
+    const string_view value = strip(setting.substr(equal + 1));
+    if (key == "indent") {
+        style.indent = number(key, value);
+    } else if (key == "max-indent") {
+        style.max_indent = number(key, value);
+    } else if (key == "comment-width") {
+        style.comment_width = number(key, value);
+    } else if (key == "operator-spacing" && (value == "on" || value == "off")) {
+        style.operator_spacing = value == "on";
+    } else if (key == "keyword-case" && value == "as-is") {
+        style.keyword_casing = Casing::AS_IS;
+    } else if (key == "keyword-case" && value == "lower") {
+        style.keyword_casing = Casing::LOWER;
+    } else if (key == "keyword-case" && value == "upper") {
+        style.keyword_casing = Casing::UPPER;
+    } else {
+        throw runtime_error("Unknown style setting \"" + string(setting) +
+                            "\"");
+    }
+}
+
+} // namespace ada_beautify
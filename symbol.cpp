@@ -2,290 +2,308 @@
 #include "symbol.hpp"
 #include "utils.hpp"
 
-#include <sstream>
-
-Symbol::Ref Symbol::cur_sym;
-Symbol::Ref Symbol::next_sym;
-
-static scanner *sc{nullptr};
-
-void Symbol::open(std::istream& is) {
-    if (sc)
-        throw std::runtime_error("Input stream already open");
-    sc = new scanner(is);
+Lexer::Lexer(std::string_view text, NameTable *_names, bool utf8,
+             std::pmr::memory_resource *_memory):
+    sc{text, utf8}, names{_names}, memory{_memory}
+{
     get();
 }
 
-const Symbol::Ref Symbol::get() {
+const Symbol::Ref Lexer::get() {
     cur_sym = next_sym;
-    if (!sc)
-        throw std::runtime_error("Input stream not open");
-    while (!sc->eof()) {
-        sc->skip_whitespace();
-        if (sc->eof()) {
-            next_sym = Symbol::Ref(new SymbolEnd());
-            return cur_sym;
+    scan();
+    next_sym->locate(start_line, start_col,
+                     start_pos, sc.position() - start_pos);
+    return cur_sym;
+}
+
+bool Lexer::skip(std::size_t offset, int line) {
+    // Nothing carries over from one line to the next:
+    sc.seek(offset, line);
+    scan();
+    next_sym->locate(start_line, start_col,
+                     start_pos, sc.position() - start_pos);
+    return true;
+}
+
+void Lexer::scan() {
+    while (!sc.eof()) {
+        sc.skip_whitespace();
+        start_line = sc.cur_line;
+        start_col = sc.cur_col;
+        start_pos = sc.position();
+        if (sc.eof()) {
+            next_sym = make_symbol<SymbolEnd>(memory);
+            return;
         }
-        switch(sc->cur_ch) {
+        switch(sc.cur_ch) {
         case '-':
-            sc->get_ch();
-            if (sc->cur_ch == '-') {
-                sc->get_ch();
-                if ((sc->cur_ch == ' ') ||
-                    (sc->cur_ch == '\t') ||
-                    (sc->cur_ch == '\n'))
+            sc.get_ch();
+            if (sc.cur_ch == '-') {
+                sc.get_ch();
+                if ((sc.cur_ch == ' ') ||
+                    (sc.cur_ch == '\t') ||
+                    (sc.cur_ch == '\n'))
                 {
-                    // This is a comment
-                    sc->skip_whitespace();
-                    std::stringstream ss;
-                    while ((sc->cur_ch != '\n') && (sc->cur_ch != EOF)) {
-                        ss << static_cast<char>(sc->cur_ch);
-                        sc->get_ch();
-                    } // end while //
+                    // This is a comment, up to the end of the line:
+                    sc.skip_whitespace();
+                    const std::size_t start = sc.position();
+                    sc.advance_to(sc.find_first_of("\n"));
                     // Suppress empty comments:
-                    std::string s = ss.str();
-                    rtrim(s);
+                    std::string_view s{sc.text_from(start)};
+                    while (!s.empty() &&
+                           std::isspace(static_cast<unsigned char>(s.back())))
+                        s.remove_suffix(1);
                     if (s.empty())
-                        next_sym = Symbol::Ref(new SymbolNewLine());
+                        next_sym = make_symbol<SymbolNewLine>(memory);
                     else
-                        next_sym = Symbol::Ref(new SymbolComment(s));
-                    return cur_sym;
+                        next_sym = make_symbol<SymbolComment>(memory, s);
+                    return;
                 }
                 // This is the -- operator
-                next_sym = Symbol::Ref(new SymbolOperator("--"));
-                return cur_sym;
+                next_sym = make_symbol<SymbolOperator>(memory, "--");
+                return;
             }
             // This is the - operator
-            next_sym = Symbol::Ref(new SymbolOperator("-"));
-            return cur_sym;
+            next_sym = make_symbol<SymbolOperator>(memory, "-");
+            return;
             break;
         case '+':
-            sc->get_ch();
-            if (sc->cur_ch == '+') {
+            sc.get_ch();
+            if (sc.cur_ch == '+') {
                 // This is the ++ operator
-                sc->get_ch();
-                next_sym = Symbol::Ref(new SymbolOperator("++"));
-                return cur_sym;
+                sc.get_ch();
+                next_sym = make_symbol<SymbolOperator>(memory, "++");
+                return;
             }
-            if (sc->cur_ch == '=') {
+            if (sc.cur_ch == '=') {
                 // This is the += operator
-                sc->get_ch();
-                next_sym = Symbol::Ref(new SymbolOperator("+="));
-                return cur_sym;
+                sc.get_ch();
+                next_sym = make_symbol<SymbolOperator>(memory, "+=");
+                return;
             }
             // This is the + operator
-            next_sym = Symbol::Ref(new SymbolOperator("+"));
-            return cur_sym;
+            next_sym = make_symbol<SymbolOperator>(memory, "+");
+            return;
         case '*':
-            sc->get_ch();
-            if (sc->cur_ch == '*') {
+            sc.get_ch();
+            if (sc.cur_ch == '*') {
                 // This is the ** operator
-                sc->get_ch();
-                next_sym = Symbol::Ref(new SymbolOperator("**"));
-                return cur_sym;
+                sc.get_ch();
+                next_sym = make_symbol<SymbolOperator>(memory, "**");
+                return;
             }
             // This is the * operator
-            next_sym = Symbol::Ref(new SymbolOperator("*"));
-            return cur_sym;
+            next_sym = make_symbol<SymbolOperator>(memory, "*");
+            return;
         case '/':
-            sc->get_ch();
-            if (sc->cur_ch == '=') {
+            sc.get_ch();
+            if (sc.cur_ch == '=') {
                 // This is the /= operator
-                sc->get_ch();
-                next_sym = Symbol::Ref(new SymbolOperator("/="));
-                return cur_sym;
+                sc.get_ch();
+                next_sym = make_symbol<SymbolOperator>(memory, "/=");
+                return;
             }
             // This is the / operator
-            next_sym = Symbol::Ref(new SymbolOperator("/"));
-            return cur_sym;
+            next_sym = make_symbol<SymbolOperator>(memory, "/");
+            return;
         case '=':
-            sc->get_ch();
-            if (sc->cur_ch == '=') {
+            sc.get_ch();
+            if (sc.cur_ch == '=') {
                 // This is the == operator
-                sc->get_ch();
-                next_sym = Symbol::Ref(new SymbolOperator("=="));
-                return cur_sym;
+                sc.get_ch();
+                next_sym = make_symbol<SymbolOperator>(memory, "==");
+                return;
             }
-            if (sc->cur_ch == '>') {
+            if (sc.cur_ch == '>') {
                 // This is the => operator
-                sc->get_ch();
-                next_sym = Symbol::Ref(new SymbolOperator("=>"));
-                return cur_sym;
+                sc.get_ch();
+                next_sym = make_symbol<SymbolOperator>(memory, "=>");
+                return;
             }
             // This is the = operator
-            next_sym = Symbol::Ref(new SymbolOperator("="));
-            return cur_sym;
+            next_sym = make_symbol<SymbolOperator>(memory, "=");
+            return;
         case '>':
-            sc->get_ch();
-            if (sc->cur_ch == '>') {
+            sc.get_ch();
+            if (sc.cur_ch == '>') {
                 // This is the >> operator
-                sc->get_ch();
-                next_sym = Symbol::Ref(new SymbolOperator(">>"));
-                return cur_sym;
+                sc.get_ch();
+                next_sym = make_symbol<SymbolOperator>(memory, ">>");
+                return;
             }
-            if (sc->cur_ch == '=') {
+            if (sc.cur_ch == '=') {
                 // This is the >= operator
-                sc->get_ch();
-                next_sym = Symbol::Ref(new SymbolOperator(">="));
-                return cur_sym;
+                sc.get_ch();
+                next_sym = make_symbol<SymbolOperator>(memory, ">=");
+                return;
             }
             // This is the > operator
-            next_sym = Symbol::Ref(new SymbolOperator(">"));
-            return cur_sym;
+            next_sym = make_symbol<SymbolOperator>(memory, ">");
+            return;
         case '<':
-            sc->get_ch();
-            if (sc->cur_ch == '<') {
+            sc.get_ch();
+            if (sc.cur_ch == '<') {
                 // This is the << operator
-                sc->get_ch();
-                next_sym = Symbol::Ref(new SymbolOperator("<<"));
-                return cur_sym;
+                sc.get_ch();
+                next_sym = make_symbol<SymbolOperator>(memory, "<<");
+                return;
             }
-            if (sc->cur_ch == '=') {
+            if (sc.cur_ch == '=') {
                 // This is the <= operator
-                sc->get_ch();
-                next_sym = Symbol::Ref(new SymbolOperator("<="));
-                return cur_sym;
+                sc.get_ch();
+                next_sym = make_symbol<SymbolOperator>(memory, "<=");
+                return;
             }
-            if (sc->cur_ch == '>') {
+            if (sc.cur_ch == '>') {
                 // This is the <> operator
-                sc->get_ch();
-                next_sym = Symbol::Ref(new SymbolOperator("/="));
-                return cur_sym;
+                sc.get_ch();
+                next_sym = make_symbol<SymbolOperator>(memory, "<>");
+                return;
             }
             // This is the < operator
-            next_sym = Symbol::Ref(new SymbolOperator("<"));
-            return cur_sym;
+            next_sym = make_symbol<SymbolOperator>(memory, "<");
+            return;
         case ':':
-            sc->get_ch();
-            if (sc->cur_ch == '=') {
+            sc.get_ch();
+            if (sc.cur_ch == '=') {
                 // This is the := operator
-                sc->get_ch();
-                next_sym = Symbol::Ref(new SymbolOperator(":="));
-                return cur_sym;
+                sc.get_ch();
+                next_sym = make_symbol<SymbolOperator>(memory, ":=");
+                return;
             }
             // This is the : operator
-            next_sym = Symbol::Ref(new SymbolOperator(":"));
-            return cur_sym;
+            next_sym = make_symbol<SymbolOperator>(memory, ":");
+            return;
         case '.':
-            sc->get_ch();
-            if (sc->cur_ch == '.') {
+            sc.get_ch();
+            if (sc.cur_ch == '.') {
                 // This is the .. operator
-                sc->get_ch();
-                next_sym = Symbol::Ref(new SymbolOperator(".."));
-                return cur_sym;
+                sc.get_ch();
+                next_sym = make_symbol<SymbolOperator>(memory, "..");
+                return;
             }
             // This is the . operator
-            next_sym = Symbol::Ref(new SymbolOperator("."));
-            return cur_sym;
+            next_sym = make_symbol<SymbolOperator>(memory, ".");
+            return;
         case ',':
-            sc->get_ch();
+            sc.get_ch();
             // This is the , operator
-            next_sym = Symbol::Ref(new SymbolOperator(","));
-            return cur_sym;
+            next_sym = make_symbol<SymbolOperator>(memory, ",");
+            return;
         case ';':
-            sc->get_ch();
+            sc.get_ch();
             // This is the ; operator
-            next_sym = Symbol::Ref(new SymbolOperator(";"));
-            return cur_sym;
+            next_sym = make_symbol<SymbolOperator>(memory, ";");
+            return;
         case '(':
-            sc->get_ch();
+            sc.get_ch();
             // This is the ( operator
-            next_sym = Symbol::Ref(new SymbolOperator("("));
-            return cur_sym;
+            next_sym = make_symbol<SymbolOperator>(memory, "(");
+            return;
         case ')':
-            sc->get_ch();
+            sc.get_ch();
             // This is the ) operator
-            next_sym = Symbol::Ref(new SymbolOperator(")"));
-            return cur_sym;
+            next_sym = make_symbol<SymbolOperator>(memory, ")");
+            return;
         case '[':
-            sc->get_ch();
+            sc.get_ch();
             // This is the [ operator
-            next_sym = Symbol::Ref(new SymbolOperator("["));
-            return cur_sym;
+            next_sym = make_symbol<SymbolOperator>(memory, "[");
+            return;
         case ']':
-            sc->get_ch();
+            sc.get_ch();
             // This is the ] operator
-            next_sym = Symbol::Ref(new SymbolOperator("]"));
-            return cur_sym;
+            next_sym = make_symbol<SymbolOperator>(memory, "]");
+            return;
         case '&':
-            sc->get_ch();
+            sc.get_ch();
             // This is the & operator
-            next_sym = Symbol::Ref(new SymbolOperator("&"));
-            return cur_sym;
+            next_sym = make_symbol<SymbolOperator>(memory, "&");
+            return;
         case '|':
-            sc->get_ch();
+            sc.get_ch();
             // This is the | operator
-            next_sym = Symbol::Ref(new SymbolOperator("|"));
-            return cur_sym;
+            next_sym = make_symbol<SymbolOperator>(memory, "|");
+            return;
         case '\n':
-            sc->get_ch();
+            sc.get_ch();
             // This is new line
-            next_sym = Symbol::Ref(new SymbolNewLine());
-            return cur_sym;
+            next_sym = make_symbol<SymbolNewLine>(memory);
+            return;
         case '#':
             {
-                sc->get_ch();
-                int x = fm_hex(sc->cur_ch) << 8;
-                sc->get_ch();
-                x |= fm_hex(sc->cur_ch);
-                sc->get_ch();
-                next_sym = Symbol::Ref(new SymbolByte(x));
-                return cur_sym;
+                // Up to two hex digits, never past the end of the text:
+                sc.get_ch();
+                int x = 0;
+                for (int i = 0; i < 2 && !sc.eof() && fm_hex(sc.cur_ch) >= 0; ++i) {
+                    x = (x << 4) | fm_hex(sc.cur_ch);
+                    sc.get_ch();
+                } // end for //
+                next_sym = make_symbol<SymbolByte>(memory, x);
+                return;
             }
         case '\'':
         {
-            sc->get_ch();
-            next_sym = Symbol::Ref(new SymbolChar(static_cast<char>(sc->cur_ch)));
-            sc->get_ch();
-            if (sc->cur_ch == '\'')
-                sc->get_ch();
-            return cur_sym;
+            sc.get_ch();
+            if (sc.eof() || sc.cur_ch == '\n') {
+                // A lone tick at the end of a line:
+                next_sym = make_symbol<SymbolOperator>(memory, "'");
+                return;
+            }
+            // With the rest of its UTF-8 sequence:
+            const std::size_t start = sc.position();
+            do {
+                sc.get_ch();
+            } while (sc.continuation());
+            next_sym = make_symbol<SymbolChar>(memory, sc.text_from(start));
+            if (sc.cur_ch == '\'')
+                sc.get_ch();
+            return;
         }
         case '"':
             {
-                std::stringstream ss;
-                sc->get_ch();
-                while (true) {
-                    if (sc->cur_ch == '"') {
-                        sc->get_ch();
-                        if (sc->cur_ch == '"') {
-                            ss << "\"";
-                            sc->get_ch();
-                            continue;
-                        } else {
-                            next_sym = Symbol::Ref(new SymbolString(ss.str()));
-                            return cur_sym;
-                        }
-                    }
-                    ss << static_cast<char>(sc->cur_ch);
-                    sc->get_ch();
-                } // end while //
+                sc.get_ch();
+                const std::size_t start = sc.position();
+                std::size_t end;
+                // A string ends at the end of its line at the latest.
+                // Doubled quotes stay as they are:
+                for (;;) {
+                    sc.advance_to(sc.find_first_of("\"\n"));
+                    end = sc.position();
+                    if (sc.cur_ch != '"')
+                        break;
+                    sc.get_ch();
+                    if (sc.cur_ch != '"')
+                        break;
+                    sc.get_ch();
+                } // end for //
+                next_sym = make_symbol<SymbolString>(
+                    memory, sc.text_from(start).substr(0, end - start));
+                return;
             }
         case '\t':
         case '\r':
-            sc->get_ch();
+            sc.get_ch();
             break;
         default:
             {
-                std::stringstream ss;
-            if (is_tokenchar(sc->cur_ch)) {
-                    do {
-                        ss << static_cast<char>(sc->cur_ch);
-                        sc->get_ch();
-                    } while (is_tokenchar(sc->cur_ch));
-                    std::string s{ss.str()};
+                if (is_tokenchar(sc.cur_ch)) {
+                    sc.advance_to(sc.token_end());
+                    const std::string_view s{sc.text_from(start_pos)};
                     if (s[0] >= '0' && s[0] <= '9')
-                        next_sym = Symbol::Ref(new SymbolNumber(s));
+                        next_sym = make_symbol<SymbolNumber>(memory, s);
+                    else if (names)
+                        next_sym = make_symbol<SymbolIdentifier>(memory, names->intern(s));
                     else
-                        next_sym = Symbol::Ref(new SymbolIdentifier(s));
-                    return cur_sym;
+                        next_sym = make_symbol<SymbolIdentifier>(memory, s);
+                    return;
                 }
-                next_sym = Symbol::Ref(new SymbolByte(sc->cur_ch));
-                sc->get_ch();
-                return cur_sym;
+                next_sym = make_symbol<SymbolByte>(memory, sc.cur_ch);
+                sc.get_ch();
+                return;
             }
         } // end switch //
     } // end while //
-    next_sym = Symbol::Ref(new SymbolEnd());
-    return cur_sym;
+    next_sym = make_symbol<SymbolEnd>(memory);
 }
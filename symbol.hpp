@@ -1,10 +1,17 @@
 #ifndef SYMBOL_HPP
 #define SYMBOL_HPP
 
+#include "names.hpp"
+#include "scanner.hpp"
 #include "utils.hpp"
 
-#include <istream>
+#include <cstdint>
+#include <initializer_list>
 #include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
 
 class Symbol
 {
@@ -23,24 +30,51 @@ public:
         COMMENT,
     };
 
-    static void open(std::istream &is);
-    static const Ref get();
-    static const Ref current() { return cur_sym; }
-    static const Ref next() { return next_sym; }
-
     virtual const Kind kind() const = 0;
     virtual const std::string to_str() const = 0;
 
-    const std::string& value() const { return _value; }
+    Symbol(const Symbol&) = delete;
+
+    const std::pmr::string& value() const { return *_value; }
+    // Id in the NameTable, 0 if the symbol is not an interned name:
+    std::uint32_t id() const { return _id; }
+    int line() const { return _line; }
+    int column() const { return _column; }
+    // Position of the symbol text in the source:
+    std::size_t offset() const { return _offset; }
+    std::size_t length() const { return _length; }
+
+    void locate(int line, int column, std::size_t offset, std::size_t length) {
+        _line = line;
+        _column = column;
+        _offset = offset;
+        _length = length;
+    }
 
 protected:
-    Symbol(const std::string& value): _value{value} {}
+    // The text is the parts one after the other, in memory:
+    Symbol(std::initializer_list<std::string_view> text,
+           std::pmr::memory_resource *memory):
+        _text{memory}, _value{&_text} {
+        for (const auto part: text)
+            _text.append(part);
+    }
+    Symbol(const NameTable::Name& name):
+        _value{name.spelling}, _id{name.id} {}
+
+    // The text behind a tag, for to_str():
+    std::string tagged(const char *tag) const {
+        return std::string(tag).append(" ").append(value());
+    }
 
 private:
-    static Ref cur_sym;
-    static Ref next_sym;
-
-    const std::string _value;
+    std::pmr::string _text{};
+    const std::pmr::string *const _value;
+    std::uint32_t _id{0};
+    int _line{0};
+    int _column{0};
+    std::size_t _offset{0};
+    std::size_t _length{0};
 };
 
 inline bool operator==(const Symbol::Ref r, Symbol::Kind k) { return k == r->kind(); }
@@ -48,7 +82,7 @@ inline bool operator!=(const Symbol::Ref r, Symbol::Kind k) { return k != r->kin
 
 class SymbolEnd: public Symbol {
 public:
-    SymbolEnd(): Symbol("\0") {};
+    SymbolEnd(std::pmr::memory_resource *memory): Symbol({"\0"}, memory) {};
 
     virtual const Kind kind() const { return Kind::END; }
     virtual const std::string to_str() const { return "END"; }
@@ -56,31 +90,38 @@ public:
 
 class SymbolOperator: public Symbol {
 public:
-    SymbolOperator(const std::string& op): Symbol(op) {};
+    SymbolOperator(std::string_view op, std::pmr::memory_resource *memory):
+        Symbol({op}, memory) {};
 
     virtual const Kind kind() const { return Kind::OPERATOR; }
-    virtual const std::string to_str() const { return "OP " + value(); }
+    virtual const std::string to_str() const { return tagged("OP"); }
 };
 
 class SymbolIdentifier: public Symbol {
 public:
-    SymbolIdentifier(const std::string& token): Symbol(token) {};
+    SymbolIdentifier(std::string_view token, std::pmr::memory_resource *memory):
+        Symbol({token}, memory) {};
+    SymbolIdentifier(const NameTable::Name& name,
+                     std::pmr::memory_resource */*memory*/):
+        Symbol(name) {};
 
     virtual const Kind kind() const { return Kind::IDENTIFIER; }
-    virtual const std::string to_str() const { return "ID " + value(); }
+    virtual const std::string to_str() const { return tagged("ID"); }
 };
 
 class SymbolNumber: public Symbol {
 public:
-    SymbolNumber(const std::string& token): Symbol(token) {};
+    SymbolNumber(std::string_view token, std::pmr::memory_resource *memory):
+        Symbol({token}, memory) {};
 
     virtual const Kind kind() const { return Kind::NUMBER; }
-    virtual const std::string to_str() const { return "NU " + value(); }
+    virtual const std::string to_str() const { return tagged("NU"); }
 };
 
 class SymbolNewLine: public Symbol {
 public:
-    SymbolNewLine(): Symbol("\n") {};
+    SymbolNewLine(std::pmr::memory_resource *memory):
+        Symbol({"\n"}, memory) {};
 
     virtual const Kind kind() const { return Kind::NL; }
     virtual const std::string to_str() const { return "NL"; }
@@ -88,34 +129,106 @@ public:
 
 class SymbolByte: public Symbol {
 public:
-    SymbolByte(const unsigned char b): Symbol("#" + to_hex(b)) {};
+    SymbolByte(const unsigned char b, std::pmr::memory_resource *memory):
+        Symbol({"#", to_hex(b)}, memory) {};
 
     virtual const Kind kind() const { return Kind::BYTE; }
-    virtual const std::string to_str() const { return "BY " + value(); }
+    virtual const std::string to_str() const { return tagged("BY"); }
 };
 
 class SymbolChar: public Symbol {
 public:
-    SymbolChar(const char c): Symbol("'" + std::string(1, c) + "'") {};
+    SymbolChar(std::string_view c, std::pmr::memory_resource *memory):
+        Symbol({"'", c, "'"}, memory) {};
 
     virtual const Kind kind() const { return Kind::CHAR; }
-    virtual const std::string to_str() const { return "CH " + value(); }
+    virtual const std::string to_str() const { return tagged("CH"); }
 };
 
 class SymbolString: public Symbol {
 public:
-    SymbolString(const std::string& text): Symbol("\"" + text + "\"") {};
+    SymbolString(std::string_view text, std::pmr::memory_resource *memory):
+        Symbol({"\"", text, "\""}, memory) {};
 
     virtual const Kind kind() const { return Kind::STRING; }
-    virtual const std::string to_str() const { return "ST " + value(); }
+    virtual const std::string to_str() const { return tagged("ST"); }
 };
 
 class SymbolComment: public Symbol {
 public:
-    SymbolComment(const std::string& text): Symbol("--  " + text) {};
+    SymbolComment(std::string_view text, std::pmr::memory_resource *memory):
+        Symbol({"--  ", text}, memory) {};
 
     virtual const Kind kind() const { return Kind::COMMENT; }
-    virtual const std::string to_str() const { return "CO " + value(); }
+    virtual const std::string to_str() const { return tagged("CO"); }
+};
+
+// A symbol restored with its final value, e.g. from a token cache:
+class SymbolRaw: public Symbol {
+public:
+    SymbolRaw(Kind kind, std::string_view value,
+              std::pmr::memory_resource *memory):
+        Symbol({value}, memory), _kind{kind} {};
+
+    virtual const Kind kind() const { return _kind; }
+    virtual const std::string to_str() const { return tagged("RA"); }
+
+private:
+    const Kind _kind;
+};
+
+// A symbol, its text and its reference count from memory, or from the
+// heap without memory:
+template <class T, class... Args>
+Symbol::Ref make_symbol(std::pmr::memory_resource *memory, Args&&... args)
+{
+    if (!memory)
+        memory = std::pmr::get_default_resource();
+    return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(memory),
+                                   std::forward<Args>(args)..., memory);
+}
+
+/**
+ * @brief SymbolSource Delivers symbols one by one with one symbol lookahead.
+ *        After the END symbol, get() keeps returning END.
+ */
+class SymbolSource
+{
+public:
+    virtual ~SymbolSource() = default;
+
+    virtual const Symbol::Ref get() = 0;
+    virtual const Symbol::Ref next() const = 0;
+    // Go on at offset, the start of line, without the symbols before.
+    // False, if the source cannot, get() delivers them then:
+    virtual bool skip(std::size_t /*offset*/, int /*line*/) { return false; }
+};
+
+class Lexer: public SymbolSource
+{
+public:
+    // Identifiers are interned in names, if given. Text, that is not
+    // UTF-8, is taken as Latin-1. Symbols come from memory, if given:
+    Lexer(std::string_view text, NameTable *_names = nullptr,
+          bool utf8 = true, std::pmr::memory_resource *_memory = nullptr);
+    Lexer(const Lexer&) = delete;
+
+    virtual const Symbol::Ref get();
+    const Symbol::Ref current() const { return cur_sym; }
+    virtual const Symbol::Ref next() const { return next_sym; }
+    virtual bool skip(std::size_t offset, int line);
+
+private:
+    void scan();
+
+    scanner sc;
+    NameTable *names;
+    std::pmr::memory_resource *memory;
+    int start_line{1};
+    int start_col{0};
+    std::size_t start_pos{0};
+    Symbol::Ref cur_sym{};
+    Symbol::Ref next_sym{};
 };
 
 #endif // SYMBOL_HPP
@@ -0,0 +1,371 @@
+#include "syntax.hpp"
+#include "keywords.hpp"
+
+#include <cctype>
+
+using namespace std;
+
+static constexpr int K_ABSTRACT   = keyword("abstract");
+static constexpr int K_ACCEPT     = keyword("accept");
+static constexpr int K_BEGIN      = keyword("begin");
+static constexpr int K_BODY       = keyword("body");
+static constexpr int K_CASE       = keyword("case");
+static constexpr int K_DECLARE    = keyword("declare");
+static constexpr int K_DO         = keyword("do");
+static constexpr int K_ELSE       = keyword("else");
+static constexpr int K_ELSIF      = keyword("elsif");
+static constexpr int K_END        = keyword("end");
+static constexpr int K_ENTRY      = keyword("entry");
+static constexpr int K_EXCEPTION  = keyword("exception");
+static constexpr int K_FOR        = keyword("for");
+static constexpr int K_FUNCTION   = keyword("function");
+static constexpr int K_GENERIC    = keyword("generic");
+static constexpr int K_IF         = keyword("if");
+static constexpr int K_IS         = keyword("is");
+static constexpr int K_LOOP       = keyword("loop");
+static constexpr int K_NEW        = keyword("new");
+static constexpr int K_NOT        = keyword("not");
+static constexpr int K_NULL       = keyword("null");
+static constexpr int K_OR         = keyword("or");
+static constexpr int K_OVERRIDING = keyword("overriding");
+static constexpr int K_PACKAGE    = keyword("package");
+static constexpr int K_PRIVATE    = keyword("private");
+static constexpr int K_PROCEDURE  = keyword("procedure");
+static constexpr int K_PROTECTED  = keyword("protected");
+static constexpr int K_RECORD     = keyword("record");
+static constexpr int K_SELECT     = keyword("select");
+static constexpr int K_SEPARATE   = keyword("separate");
+static constexpr int K_TASK       = keyword("task");
+static constexpr int K_THEN       = keyword("then");
+static constexpr int K_TYPE       = keyword("type");
+static constexpr int K_WHEN       = keyword("when");
+static constexpr int K_WHILE      = keyword("while");
+
+// Reserved word number of an identifier in any casing, 0 if it is none:
+static int word(const Symbol& sym)
+{
+    if (sym.kind() != Symbol::Kind::IDENTIFIER)
+        return 0;
+    const string_view s = sym.value();
+    char buffer[12];
+    if (s.size() > sizeof(buffer))
+        return 0;
+    for (size_t i = 0; i < s.size(); ++i)
+        buffer[i] = tolower(static_cast<unsigned char>(s[i]));
+    return keyword(string_view(buffer, s.size()));
+}
+
+static bool isUnit(int kw)
+{
+    return kw == K_PACKAGE || kw == K_PROCEDURE || kw == K_FUNCTION ||
+        kw == K_TASK || kw == K_PROTECTED || kw == K_ENTRY;
+}
+
+void SyntaxTree::parse(SymbolSource& source)
+{
+    _nodes.clear();
+    stack.clear();
+    last_line = last_end = 0;
+    last_keyword = 0;
+    after_colon = false;
+    parens = closing = 0;
+    ending = false;
+
+    _nodes.push_back(Node{Kind::ROOT, 0, false, none, none, 1, 0, 0, 0, 0, 0});
+    stack.push_back(Open{0, Phase::DECLARATIONS, false});
+    Symbol::Ref sym = source.get();
+    while (sym != Symbol::Kind::END) {
+        if (sym != Symbol::Kind::NL && sym != Symbol::Kind::COMMENT)
+            put(*sym, *source.next());
+        sym = source.get();
+    } // end while //
+    while (!stack.empty())
+        close();
+}
+
+int SyntaxTree::depth(uint32_t i) const
+{
+    int n = 0;
+    for (uint32_t p = _nodes[i].parent; p != none; p = _nodes[p].parent)
+        ++n;
+    return n;
+}
+
+void SyntaxTree::dump(ostream& os, string_view source) const
+{
+    static const char *const kinds[] = {
+        "ROOT", "UNIT", "DECLARATION", "STATEMENT", "BLOCK", "COMPOUND",
+        "ALTERNATIVE",
+    };
+    for (uint32_t i = 0; i < _nodes.size(); ++i) {
+        const Node& n = _nodes[i];
+        os << string(2 * depth(i), ' ') << kinds[static_cast<int>(n.kind)];
+        if (n.keyword)
+            os << ' ' << keywords[n.keyword - 1];
+        if (n.body)
+            os << " body";
+        if (n.name_length)
+            os << ' ' << source.substr(n.name, n.name_length);
+        os << ' ' << n.line << '-' << n.end_line << endl;
+    } // end for //
+}
+
+void SyntaxTree::put(const Symbol& sym, const Symbol& next)
+{
+    const int kw = word(sym);
+    const string_view v = sym.value();
+    const int prev_keyword = last_keyword;
+    const bool prev_colon = after_colon;
+    last_keyword = kw;
+    after_colon = (v == ":");
+
+    // Nodes closed before sym end with the symbol before it, so take()
+    // comes after close() there and before it everywhere else:
+    if (v == "(") {
+        ++parens;
+        take(sym);
+        return;
+    }
+    if (v == ")") {
+        if (parens)
+            --parens;
+        take(sym);
+        return;
+    }
+    if (parens) {
+        take(sym);
+        return;
+    }
+    if (ending) {
+        // "end [if|loop|name];":
+        take(sym);
+        if (v == ";") {
+            for (; closing; --closing)
+                close();
+            const Kind kind = _nodes[stack.back().node].kind;
+            if (kind == Kind::DECLARATION || kind == Kind::STATEMENT)
+                close();
+            ending = false;
+        }
+        return;
+    }
+
+    Open *top = &stack.back();
+    Node *n = &_nodes[top->node];
+    if (n->kind == Kind::DECLARATION || n->kind == Kind::STATEMENT) {
+        take(sym);
+        if (v == ";" || (v == ">>" && top->phase == Phase::HEADER)) {
+            close();
+        } else if (n->kind == Kind::DECLARATION && kw == K_RECORD &&
+                   prev_keyword != K_NULL) {
+            open(Kind::COMPOUND, kw, Phase::DECLARATIONS, sym);
+        } else if (n->kind == Kind::STATEMENT && prev_colon) {
+            // Label : loop, Label : declare, ...
+            compound(sym, kw);
+        }
+        return;
+    }
+
+    if (top->phase == Phase::HEADER && kw != K_END) {
+        if (top->naming) {
+            const bool dot = (n->name_length && v == ".");
+            if (kw == K_BODY || kw == K_TYPE) {
+                n->body |= (kw == K_BODY);
+                take(sym);
+                return;
+            }
+            if ((sym.kind() == Symbol::Kind::IDENTIFIER && !kw) ||
+                (sym.kind() == Symbol::Kind::STRING && !n->name_length)) {
+                if (!n->name_length)
+                    n->name = sym.offset();
+                n->name_length = sym.offset() + sym.length() - n->name;
+                take(sym);
+                top->naming = (sym.kind() == Symbol::Kind::IDENTIFIER);
+                return;
+            }
+            top->naming = dot;
+            if (dot) {
+                take(sym);
+                return;
+            }
+        }
+        take(sym);
+        if (v == ";") {
+            if (n->kind != Kind::ALTERNATIVE)
+                close();
+            return;
+        }
+        switch (n->kind) {
+        case Kind::UNIT:
+            if (kw == K_IS) {
+                const int after = word(next);
+                const string_view nv = next.value();
+                // Instances, renamings, stubs and expression functions:
+                if (after != K_NEW && after != K_SEPARATE &&
+                    after != K_ABSTRACT && after != K_NULL &&
+                    nv != "<>" && nv != "(") {
+                    // Packages, tasks and protected say "body":
+                    top->phase = Phase::DECLARATIONS;
+                    n->body |= (n->keyword == K_PROCEDURE ||
+                                n->keyword == K_FUNCTION ||
+                                n->keyword == K_ENTRY);
+                }
+            }
+            break;
+        case Kind::COMPOUND:
+            if ((n->keyword == K_IF && kw == K_THEN) ||
+                (n->keyword == K_CASE && kw == K_IS) ||
+                ((n->keyword == K_WHILE || n->keyword == K_FOR) &&
+                 kw == K_LOOP) ||
+                (n->keyword == K_ACCEPT && kw == K_DO))
+                top->phase = Phase::STATEMENTS;
+            break;
+        case Kind::ALTERNATIVE:
+            if (v == "=>" || kw == K_THEN)
+                top->phase = Phase::STATEMENTS;
+            break;
+        default:
+            break;
+        } // end switch //
+        return;
+    }
+
+    if (kw == K_END) {
+        // The alternative ends before, what it belongs to and the unit of
+        // a body with the ";":
+        if (n->kind == Kind::ALTERNATIVE)
+            close();
+        const size_t i = stack.size() - 1;
+        closing = 0;
+        if (i > 0) {
+            ++closing;
+            if (_nodes[stack[i].node].kind == Kind::BLOCK &&
+                _nodes[stack[i].node].keyword == K_BEGIN &&
+                _nodes[stack[i - 1].node].kind == Kind::UNIT)
+                ++closing;
+        }
+        ending = true;
+        take(sym);
+        return;
+    }
+    const bool declaring = declarative();
+    if (declaring && isUnit(kw)) {
+        take(sym);
+        open(Kind::UNIT, kw, Phase::HEADER, sym);
+        stack.back().naming = true;
+        return;
+    }
+    if (declaring && (kw == K_SEPARATE || kw == K_PRIVATE ||
+                      kw == K_GENERIC || kw == K_OVERRIDING ||
+                      (kw == K_NOT && word(next) == K_OVERRIDING))) {
+        take(sym);
+        return;
+    }
+    if (kw == K_BEGIN && top->phase == Phase::DECLARATIONS &&
+        n->kind == Kind::BLOCK) {
+        top->phase = Phase::STATEMENTS;
+        take(sym);
+        return;
+    }
+    if (kw == K_BEGIN && declaring) {
+        take(sym);
+        open(Kind::BLOCK, kw, Phase::STATEMENTS, sym);
+        return;
+    }
+    if (kw == K_EXCEPTION && n->kind == Kind::BLOCK) {
+        top->phase = Phase::HANDLERS;
+        take(sym);
+        return;
+    }
+    if (kw == K_WHEN || kw == K_ELSIF || kw == K_ELSE || kw == K_OR) {
+        if (n->kind == Kind::ALTERNATIVE) {
+            close();
+            top = &stack.back();
+            n = &_nodes[top->node];
+        }
+        take(sym);
+        const bool choice =
+            (kw == K_WHEN &&
+             ((n->kind == Kind::COMPOUND &&
+               (n->keyword == K_CASE || n->keyword == K_SELECT)) ||
+              (n->kind == Kind::BLOCK && top->phase == Phase::HANDLERS))) ||
+            (kw == K_ELSIF && n->keyword == K_IF) ||
+            (kw == K_ELSE && (n->keyword == K_IF || n->keyword == K_SELECT)) ||
+            (kw == K_OR && n->keyword == K_SELECT);
+        if (choice)
+            open(Kind::ALTERNATIVE, kw,
+                 kw == K_ELSE || kw == K_OR ? Phase::STATEMENTS : Phase::HEADER,
+                 sym);
+        return;
+    }
+    take(sym);
+    // Variant parts are the only compounds among declarations:
+    if (v == ";" || ((!declaring || (kw == K_CASE && n->keyword == K_RECORD)) &&
+                     compound(sym, kw)))
+        return;
+    if (v == "<<") {
+        open(Kind::STATEMENT, 0, Phase::HEADER, sym);
+        return;
+    }
+    open(declaring ? Kind::DECLARATION : Kind::STATEMENT, kw,
+         Phase::STATEMENTS, sym);
+}
+
+// Open the compound statement or block kw starts, if it does:
+bool SyntaxTree::compound(const Symbol& sym, int kw)
+{
+    if (kw == K_IF || kw == K_CASE || kw == K_ACCEPT || kw == K_WHILE ||
+        kw == K_FOR)
+        open(Kind::COMPOUND, kw, Phase::HEADER, sym);
+    else if (kw == K_LOOP || kw == K_SELECT)
+        open(Kind::COMPOUND, kw, Phase::STATEMENTS, sym);
+    else if (kw == K_DECLARE)
+        open(Kind::BLOCK, kw, Phase::DECLARATIONS, sym);
+    else if (kw == K_BEGIN)
+        open(Kind::BLOCK, kw, Phase::STATEMENTS, sym);
+    else
+        return false;
+    return true;
+}
+
+void SyntaxTree::open(Kind kind, int kw, Phase phase, const Symbol& sym)
+{
+    const uint32_t i = _nodes.size();
+    const uint32_t line = sym.line();
+    const uint32_t offset = sym.offset();
+    _nodes.push_back(Node{kind, static_cast<uint8_t>(kw), false,
+                          stack.back().node, none, line, line,
+                          offset, offset, 0, 0});
+    stack.push_back(Open{i, phase, false});
+}
+
+void SyntaxTree::close()
+{
+    Node& n = _nodes[stack.back().node];
+    stack.pop_back();
+    n.next = _nodes.size();
+    n.end_line = last_line;
+    n.end = last_end;
+}
+
+// Whether a new declaration may start here:
+bool SyntaxTree::declarative() const
+{
+    const Open& top = stack.back();
+    const Node& n = _nodes[top.node];
+    if (n.kind == Kind::ALTERNATIVE) {
+        // Of a variant part:
+        const Node& owner = _nodes[_nodes[n.parent].parent];
+        return owner.kind == Kind::COMPOUND && owner.keyword == K_RECORD;
+    }
+    return n.kind == Kind::ROOT ||
+        (n.kind == Kind::COMPOUND && n.keyword == K_RECORD) ||
+        ((n.kind == Kind::UNIT || n.kind == Kind::BLOCK) &&
+         top.phase == Phase::DECLARATIONS);
+}
+
+void SyntaxTree::take(const Symbol& sym)
+{
+    last_line = sym.line();
+    last_end = sym.offset() + sym.length();
+}
@@ -0,0 +1,97 @@
+#ifndef SYNTAX_HPP
+#define SYNTAX_HPP
+
+#include "symbol.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief SyntaxTree A cheap structural parse of a symbol stream into one
+ *        flat array of nodes in preorder. Nodes refer to each other by
+ *        index: the children of node i start at i + 1, each child's next
+ *        is the index of its sibling, and node i ends before its next.
+ *        The parse knows units, declarations, statements, blocks and
+ *        compound statements with their alternatives. It never fails,
+ *        whatever is left open at the end of the input is closed there.
+ */
+class SyntaxTree
+{
+public:
+    enum class Kind: std::uint8_t {
+        ROOT,
+        UNIT,           // Package, subprogram, task, protected, entry
+        DECLARATION,
+        STATEMENT,
+        BLOCK,          // begin ... end, declare ... end
+        COMPOUND,       // if, case, loop, select, accept, record
+        ALTERNATIVE,    // when, elsif, else, or
+    };
+
+    struct Node {
+        Kind kind;
+        std::uint8_t keyword;       // keyword() of the word it starts with
+        bool body;                  // Unit with a body, not a declaration
+        std::uint32_t parent;
+        std::uint32_t next;
+        std::uint32_t line;         // Of the first and the last symbol
+        std::uint32_t end_line;
+        std::uint32_t offset;       // Source span
+        std::uint32_t end;
+        std::uint32_t name;         // Source span of the unit name
+        std::uint32_t name_length;
+    };
+
+    static const std::uint32_t none = UINT32_MAX;
+
+    // Parse all symbols of source, up to END:
+    void parse(SymbolSource& source);
+
+    const std::vector<Node>& nodes() const { return _nodes; }
+    const Node& operator[](std::uint32_t i) const { return _nodes[i]; }
+    std::size_t size() const { return _nodes.size(); }
+
+    // Nesting level, the root is 0:
+    int depth(std::uint32_t i) const;
+
+    // One line per node, indented by depth, for debugging:
+    void dump(std::ostream& os, std::string_view source) const;
+
+private:
+    enum class Phase: std::uint8_t {
+        HEADER,         // Up to "is", "then", "loop", "=>", ...
+        DECLARATIONS,
+        STATEMENTS,
+        HANDLERS,       // After "exception"
+    };
+
+    struct Open {
+        std::uint32_t node;
+        Phase phase;
+        bool naming;    // The unit name is still to come
+    };
+
+    void put(const Symbol& sym, const Symbol& next);
+    bool compound(const Symbol& sym, int keyword);
+    void open(Kind kind, int keyword, Phase phase, const Symbol& sym);
+    void close();
+    bool declarative() const;
+    void take(const Symbol& sym);
+
+    std::vector<Node> _nodes{};
+    std::vector<Open> stack{};
+
+    // The last symbol, closed nodes end with it:
+    std::uint32_t last_line{0};
+    std::uint32_t last_end{0};
+    int last_keyword{0};
+    bool after_colon{false};
+
+    int parens{0};
+    bool ending{false}; // After "end", up to the next ";"
+    int closing{0};     // Nodes to close then
+};
+
+#endif // SYNTAX_HPP
@@ -0,0 +1,68 @@
+# Format the Ada sources changed in a scratch git repository, from one of
+# its directories. Of the golden inputs there, the one modified, also given
+# on the command line, and the one added must come out as expected. The one
+# committed, the one outside the directory and other files stay as they
+# are:
+#
+#   cmake -DBEAUTIFY=<exe> -DGIT=<exe> -DGOLDEN=<dir> -DOUTPUT=<dir>
+#         -P changed.cmake
+
+file(REMOVE_RECURSE ${OUTPUT})
+file(MAKE_DIRECTORY ${OUTPUT}/src)
+
+function(git)
+    execute_process(COMMAND ${GIT} -c user.name=test
+                                   -c user.email=test@example.com ${ARGN}
+                    WORKING_DIRECTORY ${OUTPUT}
+                    OUTPUT_QUIET
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "git ${ARGN} failed: ${result}")
+    endif()
+endfunction()
+
+# Copy the golden input or expected text of name to file in the repository:
+function(put name kind file)
+    configure_file(${GOLDEN}/${name}.${kind} ${OUTPUT}/${file} COPYONLY)
+endfunction()
+
+function(compare file name kind)
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files
+                            ${OUTPUT}/${file} ${GOLDEN}/${name}.${kind}
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${OUTPUT}/${file} differs from "
+                            "${GOLDEN}/${name}.${kind}")
+    endif()
+endfunction()
+
+git(init --quiet)
+put(parens adb src/committed.adb)
+put(record expected src/modified.adb)
+put(loop_exit expected top.adb)
+file(WRITE ${OUTPUT}/src/notes.txt "procedure Notes is\n")
+git(add .)
+git(commit --quiet -m base)
+
+put(record adb src/modified.adb)
+put(case_when adb src/added.ads)
+put(loop_exit adb top.adb)
+file(APPEND ${OUTPUT}/src/notes.txt "begin null; end;\n")
+git(add src/added.ads)
+
+execute_process(COMMAND ${BEAUTIFY} -g HEAD -j 2 modified.adb
+                WORKING_DIRECTORY ${OUTPUT}/src
+                ERROR_VARIABLE errors
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Formatting the changes failed: ${result}\n${errors}")
+endif()
+
+compare(src/modified.adb record expected)
+compare(src/added.ads case_when expected)
+compare(src/committed.adb parens adb)
+compare(top.adb loop_exit adb)
+file(READ ${OUTPUT}/src/notes.txt notes)
+if(NOT notes STREQUAL "procedure Notes is\nbegin null; end;\n")
+    message(FATAL_ERROR "${OUTPUT}/src/notes.txt was changed:\n${notes}")
+endif()
@@ -0,0 +1,46 @@
+# Write the diff of copies of the golden inputs, that take no options, in
+# one run, apply it with PATCH and compare each copy with its expected
+# text:
+#
+#   cmake -DBEAUTIFY=<exe> -DPATCH=<exe> -DGOLDEN=<dir> -DOUTPUT=<dir>
+#         -P diff.cmake
+
+file(REMOVE_RECURSE ${OUTPUT})
+file(MAKE_DIRECTORY ${OUTPUT})
+
+file(GLOB inputs ${GOLDEN}/*.adb)
+set(names)
+foreach(input ${inputs})
+    get_filename_component(name ${input} NAME_WE)
+    if(NOT EXISTS ${GOLDEN}/${name}.options)
+        file(COPY ${input} DESTINATION ${OUTPUT})
+        list(APPEND names ${name}.adb)
+    endif()
+endforeach()
+
+# Run in the directory, so that the names in the diff are the ones to patch:
+execute_process(COMMAND ${BEAUTIFY} -d ${names}
+                WORKING_DIRECTORY ${OUTPUT}
+                OUTPUT_FILE ${OUTPUT}/golden.diff
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Writing the diff failed: ${result}")
+endif()
+
+execute_process(COMMAND ${PATCH} -p0 --quiet -i golden.diff
+                WORKING_DIRECTORY ${OUTPUT}
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${OUTPUT}/golden.diff does not apply: ${result}")
+endif()
+
+foreach(name ${names})
+    get_filename_component(name ${name} NAME_WE)
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files
+                            ${OUTPUT}/${name}.adb ${GOLDEN}/${name}.expected
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${OUTPUT}/${name}.adb patched differs from "
+                            "${GOLDEN}/${name}.expected")
+    endif()
+endforeach()
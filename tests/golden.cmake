@@ -0,0 +1,53 @@
+# Format INPUT with BEAUTIFY and compare the result with EXPECTED, and
+# its source map with MAP, if that file exists. The expected text must
+# also pass the check as it is, unless it is an outline or verbose.
+#
+#   cmake -DBEAUTIFY=<exe> -DOPTIONS=<options> -DINPUT=<file>
+#         -DEXPECTED=<file> -DOUTPUT=<file> [-DMAP=<file>] -P golden.cmake
+
+separate_arguments(OPTIONS UNIX_COMMAND "${OPTIONS}")
+
+# Run next to the input, so that file names in the output are short:
+get_filename_component(input_dir ${INPUT} DIRECTORY)
+get_filename_component(input_name ${INPUT} NAME)
+set(map_options)
+if(MAP AND EXISTS ${MAP})
+    set(map_options --source-map ${OUTPUT}.map)
+endif()
+execute_process(COMMAND ${BEAUTIFY} ${OPTIONS} ${map_options}
+                        -i ${input_name} -o ${OUTPUT}
+                WORKING_DIRECTORY ${input_dir}
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Formatting ${INPUT} failed: ${result}")
+endif()
+
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${OUTPUT} ${EXPECTED}
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    file(READ ${OUTPUT} actual)
+    message(FATAL_ERROR "${OUTPUT} differs from ${EXPECTED}:\n${actual}")
+endif()
+
+if(map_options)
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files
+                            ${OUTPUT}.map ${MAP}
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${OUTPUT}.map differs from ${MAP}")
+    endif()
+endif()
+
+# An outline is no Ada text to check, and the scope levels -v adds
+# would be added once more:
+list(FIND OPTIONS "--outline" outline)
+list(FIND OPTIONS "-v" verbose)
+if(NOT outline EQUAL -1 OR NOT verbose EQUAL -1)
+    return()
+endif()
+
+execute_process(COMMAND ${BEAUTIFY} ${OPTIONS} -c -i ${EXPECTED}
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${EXPECTED} changes when formatted again")
+endif()
@@ -0,0 +1,12 @@
+package Align is
+type Point is record
+X : Integer;
+Long_Name : Integer := 0;
+Y : Float := 1.0;
+end record;
+Origin : constant Point := (X => 0, Long_Name => 0, Y => 0.0);
+Count : Natural := 0;
+Flag : Boolean;
+procedure Set (Item : in out Point; Value : Integer);
+Limit : constant := 10;
+end Align;
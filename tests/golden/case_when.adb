@@ -0,0 +1,9 @@
+procedure Case_When is
+begin
+case X is
+when 1 => Y := 2;
+when 2 | 3 => Y := 3;
+Z := 4;
+when others => null;
+end case;
+end Case_When;
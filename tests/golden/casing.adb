@@ -0,0 +1,8 @@
+with Ada.Text_Io;
+
+procedure Casing is
+   Total_COUNT : Integer := 0;
+begin
+   total_count := TOTAL_Count + 1;
+   Ada.Text_IO.Put_Line (Integer'Image (Total_Count));
+end CASING;
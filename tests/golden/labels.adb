@@ -0,0 +1,10 @@
+procedure Labels is
+begin
+<<Again>> I := I + 1;
+if I < 10 then
+goto Again;
+end if;
+Outer : loop
+exit Outer when I > 20;
+end loop Outer;
+end Labels;
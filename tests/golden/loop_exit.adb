@@ -0,0 +1,13 @@
+procedure Loop_Exit is
+begin
+loop
+I := I + 1;
+exit when I > 10;
+end loop;
+while I > 0 loop
+I := I - 1;
+end loop;
+for J in 1 .. 10 loop
+exit;
+end loop;
+end Loop_Exit;
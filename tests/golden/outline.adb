@@ -0,0 +1,49 @@
+with Ada.Text_IO;
+package body Shapes.Areas is
+
+   type Shape (Round : Boolean) is record
+      case Round is
+         when True => Radius : Float;
+         when False => Width, Height : Float;
+      end case;
+   end record;
+
+   package Counters is
+      procedure Count;
+   end Counters;
+
+   package body Counters is
+      N : Natural := 0;
+      procedure Count is
+      begin
+         N := N + 1;
+      end Count;
+   end Counters;
+
+   function Area (S : Shape) return Float is
+   begin
+      if S.Round then
+         return 3.14 * S.Radius * S.Radius;
+      else
+         return S.Width * S.Height;
+      end if;
+   end Area;
+
+   function "<" (L, R : Shape) return Boolean is (Area (L) < Area (R));
+
+   procedure Print (S : Shape) is separate;
+
+   task Worker is
+      entry Start (S : Shape);
+   end Worker;
+
+   task body Worker is
+   begin
+      accept Start (S : Shape) do
+         Counters.Count;
+      end Start;
+   end Worker;
+
+   package Float_IO is new Ada.Text_IO.Float_IO (Float);
+
+end Shapes.Areas;
@@ -0,0 +1,8 @@
+procedure Parens is
+begin
+Put_Line (Image (X, Width => 3));
+Y := F (A => 1, B => (C => 2, D => 3));
+if (A and then B) or else (C > (D + 1)) then
+null;
+end if;
+end Parens;
@@ -0,0 +1,7 @@
+package Records is
+type Point is record
+X : Integer;
+Y : Integer;
+end record;
+type Empty is null record;
+end Records;
@@ -0,0 +1,19 @@
+package body Reflow is
+   -- This is a very long comment translated by P2Ada from the original Pascal source, which had lines of more than one hundred and twenty characters, as Pascal programmers liked them.
+   -- It goes on in a second line.
+   procedure P is
+   begin
+      -- [P2Ada]: no otherwise / else in Pascal, and this note is long enough to be wrapped around
+      -- Steps:
+      -- - first step, which takes a lot of words to describe in full detail here
+      -- - second step
+      -- 1. numbered item that also is rather long and needs to be wrapped somewhere
+      -- X := Compute (A, B) + Some_Other_Function_With_A_Long_Name (C, D, E, F);
+      -- ---------------------------------------------------------------------------
+      -- Kurze Zeile.
+      -- Größenänderung der Fläche über die gesamte Länge der Straße, für jede einzelne Spur.
+      null; -- trailing note
+      --
+      -- Separate paragraph after an empty comment line, short.
+   end P;
+end Reflow;
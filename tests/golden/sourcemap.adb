@@ -0,0 +1,8 @@
+with Ada.Text_IO; use Ada.Text_IO;
+procedure Mapped is
+   -- Comment lines map one to one.
+   X : Integer := 0;
+begin
+for I in 1 .. 10 loop X := X + I; end loop;
+   if X > 10 then Put_Line (File => Standard_Output, Item => "Sum is larger than ten"); end if;
+end Mapped;
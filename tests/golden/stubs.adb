@@ -0,0 +1,10 @@
+package body Stubs is
+   type Count is new Integer;
+   procedure First is separate;
+   procedure Second is null;
+   function Third return Count is
+   begin
+      return 3;
+   end Third;
+end Stubs;
+-- Trailing comments stay.
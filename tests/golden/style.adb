@@ -0,0 +1,22 @@
+package body Styled is
+   function Area (X, Y : Integer) return Integer is
+      Z : Integer := -X;
+   begin
+      if X > 0 AND THEN Y > 0 then
+         return X * Y + Z - (-1) ** 2;
+      else
+         case X is
+            when 1 => return Ptr.all + 1;
+            when others => null;
+         end case;
+      end if;
+      for I in 1 .. 3 loop
+         Z := Z & "a";
+      end loop;
+      return 0;
+   end Area;
+   type R is null record;
+   type Q is record
+      A : Integer;
+   end record;
+end Styled;
@@ -0,0 +1,11 @@
+package body Größen is
+   Maß : Integer := 1; -- Länge in Metern
+   Höhe : Float;
+   Breite_Außen : Float := 2.0;
+   Grad : constant Character := '°';
+   function Fläche (Länge, Größe : Float) return Float is
+   begin
+      return Maß_Für_Die_Fläche (Länge) * Größe + Maß_Für_Die_Fläche (Größe) * Länge;
+   end Fläche;
+   Text : constant String := "Grüße ""aus"" Köln";
+end Größen;
@@ -0,0 +1,14 @@
+package body Counters is
+--  Counts up and down.
+procedure Step (I : in out Integer) is
+begin
+if I > 0 then
+I := I - 1;   -- down
+else
+loop
+I := I + 1;
+exit when I > 10;
+end loop;
+end if;
+end Step;
+end Counters;
@@ -0,0 +1,6 @@
+generic
+   type Element is (<>);
+package Lists.Sorted is
+   procedure Insert (X : Element);   --  keeps its place
+   function Check (A, B : Boolean) return Boolean is (A and then B);
+end Lists.Sorted;
@@ -0,0 +1,8 @@
+procedure Wrap is
+begin
+Result := Compute_Something (First_Argument, Second_Argument, Third_Argument);
+Total := Alpha + Beta * Gamma - Delta_Value + Epsilon / Zeta + Eta_Value + Theta;
+if Alpha_Value > Beta_Value and then Gamma_Value < (Delta_Value + Round ((X - Y) * Slope)) then
+Put_Line (Ada.Strings.Unbounded.To_String (Name) & " has " & Integer'Image (Count));
+end if;
+end Wrap;
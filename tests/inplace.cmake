@@ -0,0 +1,99 @@
+# Check, then format in place, copies of the golden inputs, that take no
+# options, in one parallel run. The check must fail and name every copy
+# not formatted yet. Formatted, each copy must equal its expected text,
+# keep its mode and pass the check:
+#
+#   cmake -DBEAUTIFY=<exe> -DGOLDEN=<dir> -DOUTPUT=<dir> -P inplace.cmake
+
+file(REMOVE_RECURSE ${OUTPUT})
+file(MAKE_DIRECTORY ${OUTPUT})
+
+# Every other copy is executable, the rest is not readable to others:
+file(GLOB inputs ${GOLDEN}/*.adb)
+set(names)
+set(modes)
+set(changed)
+foreach(input ${inputs})
+    get_filename_component(name ${input} NAME_WE)
+    if(EXISTS ${GOLDEN}/${name}.options)
+        continue()
+    endif()
+    list(LENGTH names count)
+    math(EXPR odd "${count} % 2")
+    if(odd)
+        set(mode -rwxr-xr-x)
+        set(permissions OWNER_EXECUTE GROUP_EXECUTE WORLD_READ WORLD_EXECUTE)
+    else()
+        set(mode -rw-r-----)
+        set(permissions)
+    endif()
+    file(COPY ${input} DESTINATION ${OUTPUT})
+    file(CHMOD ${OUTPUT}/${name}.adb
+         PERMISSIONS OWNER_READ OWNER_WRITE GROUP_READ ${permissions})
+    list(APPEND names ${name}.adb)
+    list(APPEND modes ${mode})
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files
+                            ${input} ${GOLDEN}/${name}.expected
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        list(APPEND changed ${name}.adb)
+    endif()
+endforeach()
+if(NOT changed)
+    message(FATAL_ERROR "No golden input in ${GOLDEN} to format")
+endif()
+
+function(check expected)
+    execute_process(COMMAND ${BEAUTIFY} -c -j 2 ${names}
+                    WORKING_DIRECTORY ${OUTPUT}
+                    OUTPUT_VARIABLE report
+                    ERROR_VARIABLE report
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL expected)
+        message(FATAL_ERROR "Check exits with ${result}, not ${expected}:\n"
+                            "${report}")
+    endif()
+    foreach(name ${ARGN})
+        string(FIND "${report}" "${name}:" found)
+        if(found EQUAL -1)
+            message(FATAL_ERROR "Check does not name ${name}:\n${report}")
+        endif()
+    endforeach()
+endfunction()
+
+check(1 ${changed})
+
+execute_process(COMMAND ${BEAUTIFY} -j 2 ${names}
+                WORKING_DIRECTORY ${OUTPUT}
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Formatting in place failed: ${result}")
+endif()
+
+foreach(name mode IN ZIP_LISTS names modes)
+    get_filename_component(base ${name} NAME_WE)
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files
+                            ${OUTPUT}/${name} ${GOLDEN}/${base}.expected
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${OUTPUT}/${name} differs from "
+                            "${GOLDEN}/${base}.expected")
+    endif()
+    execute_process(COMMAND ls -l ${name}
+                    WORKING_DIRECTORY ${OUTPUT}
+                    OUTPUT_VARIABLE listing)
+    string(SUBSTRING "${listing}" 0 10 actual)
+    if(NOT actual STREQUAL mode)
+        message(FATAL_ERROR "${OUTPUT}/${name} is ${actual}, not ${mode}")
+    endif()
+endforeach()
+
+# No temporary file is left behind:
+file(GLOB left ${OUTPUT}/*)
+list(LENGTH left count)
+list(LENGTH names expected)
+if(NOT count EQUAL expected)
+    message(FATAL_ERROR "Files left in ${OUTPUT}: ${left}")
+endif()
+
+check(0)
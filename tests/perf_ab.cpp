@@ -0,0 +1,398 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+using namespace std;
+using namespace filesystem;
+
+// Compares two builds of the tool, A and B, on a corpus. Both run in turns
+// on every file, pinned to one CPU, after some runs to warm up. Each run
+// must give the same output and exit status from both. Reports how much
+// faster B is than A, per file and over the whole corpus, with confidence
+// intervals and the p-value of a Wilcoxon signed-rank test, and flags the
+// files where B is slower beyond doubt. Fails only on different outputs.
+//
+// Builds with BUILD_SHARED_LIBS compare their libraries this way, as each
+// tool loads the library next to it.
+
+/**
+ * @brief Settings What the command line asks for.
+ */
+struct Settings
+{
+    int runs{21};               // Timed runs of each tool on each file
+    int warmup{2};              // Untimed runs before
+    int cpu{-1};                // CPU to run on, -1 for the current one
+    double alpha{0.01};         // Level of the tests and of the intervals
+    double threshold{2.0};      // Slowdown in % to flag, if significant
+    string a{};
+    string b{};
+    vector<string> files{};
+    vector<string> options{};   // For both tools
+};
+
+/**
+ * @brief Result One run of a tool on a file.
+ */
+struct Result
+{
+    string output{};
+    int status{0};
+    double time{0.0};           // Microseconds from start to exit
+};
+
+/**
+ * @brief Comparison Speedup of B over A from paired times.
+ */
+struct Comparison
+{
+    double speedup{1.0};        // Time of A / time of B, geometric mean
+    double low{1.0};
+    double high{1.0};
+    double p{1.0};
+};
+
+static void usage(const char *name)
+{
+    cerr << "Usage: " << name << " [options] <tool A> <tool B> <files or "
+         << "directories...> [-- <tool options...>]" << endl
+         << "\t-n <runs> ..... Timed runs per tool and file (21)" << endl
+         << "\t-w <runs> ..... Runs to warm up (2)" << endl
+         << "\t-c <cpu> ...... CPU to pin to (the current one)" << endl
+         << "\t-a <alpha> .... Significance level (0.01)" << endl
+         << "\t-t <percent> .. Slowdown to flag as regressed (2)" << endl;
+}
+
+static Settings parse(int argc, char *argv[])
+{
+    Settings settings;
+    int arg{1};
+    for (; arg < argc && argv[arg][0] == '-' && argv[arg][1]; ++arg) {
+        const string flag{argv[arg]};
+        if (flag == "--")
+            break;
+        if (flag.size() != 2 || arg + 1 == argc || !strchr("nwcat", flag[1]))
+            throw invalid_argument(flag);
+        const char *value{argv[++arg]};
+        switch (flag[1]) {
+        case 'n':
+            settings.runs = atoi(value);
+            break;
+        case 'w':
+            settings.warmup = atoi(value);
+            break;
+        case 'c':
+            settings.cpu = atoi(value);
+            break;
+        case 'a':
+            settings.alpha = atof(value);
+            break;
+        case 't':
+            settings.threshold = atof(value);
+            break;
+        } // end switch //
+    } // end for //
+    for (; arg < argc && strcmp(argv[arg], "--") != 0; ++arg) {
+        if (settings.a.empty())
+            settings.a = argv[arg];
+        else if (settings.b.empty())
+            settings.b = argv[arg];
+        else
+            settings.files.push_back(argv[arg]);
+    } // end for //
+    for (++arg; arg < argc; ++arg)
+        settings.options.push_back(argv[arg]);
+    if (settings.files.empty() || settings.runs < 2 || settings.warmup < 0 ||
+        settings.alpha <= 0.0 || settings.alpha >= 1.0)
+        throw invalid_argument("");
+    return settings;
+}
+
+// The Ada sources of files, directories searched through, in order:
+static vector<string> corpus(const vector<string>& names)
+{
+    vector<string> files;
+    for (const auto& name: names) {
+        if (!is_directory(name)) {
+            files.push_back(name);
+            continue;
+        }
+        vector<string> found;
+        for (const auto& entry: recursive_directory_iterator(name)) {
+            const string extension = entry.path().extension().string();
+            if (entry.is_regular_file() && (extension == ".adb" ||
+                extension == ".ads" || extension == ".ada"))
+                found.push_back(entry.path().string());
+        } // end for //
+        sort(found.begin(), found.end());
+        files.insert(files.end(), found.begin(), found.end());
+    } // end for //
+    if (files.empty())
+        throw runtime_error("Empty corpus");
+    return files;
+}
+
+static void pin(int cpu)
+{
+    if (cpu < 0)
+        cpu = sched_getcpu();
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0)
+        throw runtime_error("Unable to pin to CPU " + to_string(cpu) + ": " +
+                            strerror(errno));
+    cout << "Pinned to CPU " << cpu << endl;
+}
+
+// Run tool on file, stdout read into the result, stderr dropped. The
+// tools inherit the CPU of this process:
+static Result run(const string& tool, const vector<string>& options,
+                  const string& file)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+        throw runtime_error(string("pipe: ") + strerror(errno));
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    posix_spawn_file_actions_addclose(&actions, fds[1]);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null",
+                                     O_RDONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null",
+                                     O_WRONLY, 0);
+    vector<char*> args;
+    args.push_back(const_cast<char*>(tool.c_str()));
+    for (const auto& option: options)
+        args.push_back(const_cast<char*>(option.c_str()));
+    args.push_back(const_cast<char*>("-i"));
+    args.push_back(const_cast<char*>(file.c_str()));
+    args.push_back(nullptr);
+
+    Result result;
+    const auto start = chrono::steady_clock::now();
+    pid_t pid;
+    const int error = posix_spawn(&pid, tool.c_str(), &actions, nullptr,
+                                  args.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    if (error) {
+        close(fds[0]);
+        throw runtime_error("Unable to start \"" + tool + "\": " +
+                            strerror(error));
+    }
+    char buffer[65536];
+    ssize_t size;
+    while ((size = read(fds[0], buffer, sizeof(buffer))) > 0)
+        result.output.append(buffer, size);
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    const chrono::duration<double, micro> elapsed =
+        chrono::steady_clock::now() - start;
+    result.time = elapsed.count();
+    if (!WIFEXITED(status))
+        throw runtime_error("\"" + tool + "\" crashed on \"" + file + "\"");
+    result.status = WEXITSTATUS(status);
+    return result;
+}
+
+static void same(const Result& a, const Result& b, const string& file)
+{
+    if (a.status != b.status)
+        throw runtime_error("Exit status " + to_string(a.status) + " of A, " +
+                            to_string(b.status) + " of B on \"" + file +
+                            "\"");
+    if (a.output == b.output)
+        return;
+    const auto [pa, pb] = mismatch(a.output.begin(), a.output.end(),
+                                   b.output.begin(), b.output.end());
+    throw runtime_error("Outputs differ on \"" + file + "\" at byte " +
+                        to_string(pa - a.output.begin()));
+}
+
+// Two-sided p-value of the Wilcoxon signed-rank test, that the
+// differences d are centered on 0, in the normal approximation:
+static double signed_rank(const vector<double>& d)
+{
+    vector<double> v;
+    for (double x: d)
+        if (x != 0.0)
+            v.push_back(x);
+    const size_t n = v.size();
+    if (n == 0)
+        return 1.0;
+    sort(v.begin(), v.end(), [] (double x, double y) {
+        return fabs(x) < fabs(y);
+    });
+    double w{0.0};              // Sum of the ranks of the positive ones
+    double ties{0.0};
+    for (size_t i = 0; i < n;) {
+        size_t j = i;
+        while (j < n && fabs(v[j]) == fabs(v[i]))
+            ++j;
+        const double rank = (i + 1 + j) / 2.0;
+        for (size_t k = i; k < j; ++k)
+            if (v[k] > 0.0)
+                w += rank;
+        const double t = j - i;
+        ties += t * t * t - t;
+        i = j;
+    } // end for //
+    const double mean = n * (n + 1) / 4.0;
+    const double variance = n * (n + 1) * (2 * n + 1) / 24.0 - ties / 48.0;
+    if (variance <= 0.0)
+        return 1.0;
+    const double z = max(fabs(w - mean) - 0.5, 0.0) / sqrt(variance);
+    return erfc(z / sqrt(2.0));
+}
+
+// Paired runs of A and B, one time of each per run:
+static Comparison compare(const vector<double>& a, const vector<double>& b,
+                          double alpha)
+{
+    const size_t n = a.size();
+    vector<double> d(n);
+    for (size_t i = 0; i < n; ++i)
+        d[i] = log(a[i] / b[i]);
+    auto mean = [] (const vector<double>& v) {
+        double sum{0.0};
+        for (double x: v)
+            sum += x;
+        return sum / v.size();
+    };
+    // Percentile bootstrap of the mean log ratio, the same on every run:
+    static const int resamples = 2000;
+    mt19937 rng(4711);
+    uniform_int_distribution<size_t> pick(0, n - 1);
+    vector<double> means(resamples);
+    vector<double> sample(n);
+    for (auto& m: means) {
+        for (auto& x: sample)
+            x = d[pick(rng)];
+        m = mean(sample);
+    } // end for //
+    sort(means.begin(), means.end());
+    const size_t cut = static_cast<size_t>(alpha / 2 * resamples);
+
+    Comparison result;
+    result.speedup = exp(mean(d));
+    result.low = exp(means[cut]);
+    result.high = exp(means[resamples - 1 - cut]);
+    result.p = signed_rank(d);
+    return result;
+}
+
+static double median(vector<double> v)
+{
+    nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+}
+
+static void row(const string& name, const vector<double>& a,
+                const vector<double>& b, const Comparison& c,
+                const char *flag)
+{
+    cout << left << setw(40) << name << right << fixed
+         << setprecision(0) << setw(10) << median(a) << setw(10) << median(b)
+         << setprecision(3) << setw(9) << c.speedup << "  [" << c.low << ", "
+         << c.high << "]" << setprecision(4) << setw(9) << c.p << "  "
+         << flag << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    Settings settings;
+    try {
+        settings = parse(argc, argv);
+    }
+    catch (const invalid_argument&) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        const vector<string> files = corpus(settings.files);
+        pin(settings.cpu);
+        const size_t count = files.size();
+        // Times of A and B by file and run:
+        vector<vector<double>> a(count), b(count);
+        // Turns alternate, which tool runs first, on every file and run,
+        // so that a drift of the box hits both the same:
+        for (int r = -settings.warmup; r < settings.runs; ++r) {
+            for (size_t f = 0; f < count; ++f) {
+                Result ra, rb;
+                if ((r + settings.warmup + f) % 2 == 0) {
+                    ra = run(settings.a, settings.options, files[f]);
+                    rb = run(settings.b, settings.options, files[f]);
+                } else {
+                    rb = run(settings.b, settings.options, files[f]);
+                    ra = run(settings.a, settings.options, files[f]);
+                }
+                same(ra, rb, files[f]);
+                if (r >= 0) {
+                    a[f].push_back(ra.time);
+                    b[f].push_back(rb.time);
+                }
+            } // end for //
+        } // end for //
+
+        cout << left << setw(40) << "file" << right << setw(10) << "A us"
+             << setw(10) << "B us" << setw(9) << "A/B" << "  "
+             << setw(16) << left << (to_string(
+                    static_cast<int>(round((1 - settings.alpha) * 100))) +
+                    "% interval") << right << setw(7) << "p" << endl;
+        const double floor = 1.0 / (1.0 + settings.threshold / 100.0);
+        size_t faster{0}, slower{0}, regressed{0};
+        vector<double> total_a(settings.runs), total_b(settings.runs);
+        for (size_t f = 0; f < count; ++f) {
+            const Comparison c = compare(a[f], b[f], settings.alpha);
+            const bool significant = c.p < settings.alpha;
+            const char *flag = "";
+            if (significant && c.speedup > 1.0) {
+                ++faster;
+            } else if (significant) {
+                ++slower;
+                if (c.speedup < floor) {
+                    ++regressed;
+                    flag = "REGRESSED";
+                }
+            }
+            row(files[f], a[f], b[f], c, flag);
+            for (int r = 0; r < settings.runs; ++r) {
+                total_a[r] += a[f][r];
+                total_b[r] += b[f][r];
+            } // end for //
+        } // end for //
+        const Comparison c = compare(total_a, total_b, settings.alpha);
+        const char *flag = c.p < settings.alpha && c.speedup < floor ?
+            "REGRESSED" : "";
+        row("total", total_a, total_b, c, flag);
+        cout << count << " files, the same output from A and B. B is faster "
+             << "on " << faster << ", slower on " << slower << ", regressed "
+             << "on " << regressed << endl;
+    }
+    catch (const exception& ex) {
+        cerr << "Fatal error: " << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,223 @@
+#include "ada_beautify.hpp"
+#include "symbol.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Measures tokens per second on a fixed corpus and compares the result
+// with a baseline file of "<corpus> <speed>" lines. The speed is the one
+// relative to a reference workload timed in turns with the formatting, so
+// that neither the box nor its load changes it much.
+
+static const size_t corpusSize = 1 << 20;
+static const int runs = 5;
+
+static void usage(const char *name)
+{
+    cerr << "Usage: " << name
+         << " [--update] <corpus> <baseline> <tolerance %> [files...]" << endl
+         << "The corpus repeats the files, or is synthetic without files."
+         << endl;
+}
+
+/**
+ * @brief NullSink Drops the formatted text and the diagnostics.
+ */
+class NullSink: public ada_beautify::OutputSink
+{
+public:
+    void write(string_view) override {}
+    void diagnostic(const ada_beautify::Diagnostic&) override {}
+};
+
+static string read_file(const string& file)
+{
+    ifstream ifs(file, ios::binary);
+    if (!ifs.is_open())
+        throw runtime_error("Unable to open \"" + file + "\"");
+    stringstream ss;
+    ss << ifs.rdbuf();
+    return ss.str();
+}
+
+// Units made of the words the handlers care about, the same on every box:
+static string synthetic()
+{
+    static const char *words[] {
+        "begin", "end", ";", "loop", "exit", "when", "null", "if", "then",
+        "else", "case", "is", "=>", "others", "record", "type", "(", ")",
+        ",", ".", "X", "Y_1", ":=", "+", "42", "\"text\"", "'c'",
+        "and then", "or else", "\n", "\n", "-- comment\n"
+    };
+    const size_t count = sizeof(words) / sizeof(words[0]);
+    mt19937 rng(4711);
+    string text;
+    while (text.size() < corpusSize) {
+        text += "\nprocedure P is\nbegin\n";
+        const unsigned length = rng() % 200;
+        for (unsigned i = 0; i < length; ++i) {
+            text += words[rng() % count];
+            text += ' ';
+        } // end for //
+        text += "\nend P;\n";
+    } // end while //
+    return text;
+}
+
+static size_t tokens(string_view text)
+{
+    size_t count{0};
+    Lexer lexer(text);
+    while (lexer.get() != Symbol::Kind::END)
+        ++count;
+    return count;
+}
+
+// Work of the same kind as formatting, strings made, compared and looked
+// up, but none of the code of the formatter. Returns the distinct words:
+static size_t reference(const string& text)
+{
+    vector<string> words;
+    size_t pos{0};
+    while ((pos = text.find_first_not_of(" \n", pos)) != string::npos) {
+        const size_t end = min(text.find_first_of(" \n", pos), text.size());
+        words.emplace_back(text, pos, end - pos);
+        pos = end;
+    } // end while //
+    sort(words.begin(), words.end());
+    unordered_map<string, size_t> counts;
+    for (const auto& word: words)
+        ++counts[word];
+    return counts.size();
+}
+
+// Seconds of formatting text and of the reference on it, the best of the
+// runs, taken in turns:
+static pair<double, double> measure(const string& text)
+{
+    ada_beautify::Options options;
+    NullSink sink;
+    double best{0.0};
+    double best_reference{0.0};
+    for (int i = 0; i < runs; ++i) {
+        auto start = chrono::steady_clock::now();
+        ada_beautify::format(text, options, sink);
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        if (i == 0 || elapsed.count() < best)
+            best = elapsed.count();
+        start = chrono::steady_clock::now();
+        if (reference(text) == 0)
+            throw runtime_error("Empty reference");
+        elapsed = chrono::steady_clock::now() - start;
+        if (i == 0 || elapsed.count() < best_reference)
+            best_reference = elapsed.count();
+    } // end for //
+    return { best, best_reference };
+}
+
+// Replace the line of the corpus, or add one:
+static void update(const string& file, const string& corpus, double speed)
+{
+    vector<string> lines;
+    {
+        ifstream ifs(file);
+        string line;
+        while (getline(ifs, line)) {
+            if (line.compare(0, corpus.size() + 1, corpus + " ") != 0)
+                lines.push_back(line);
+        } // end while //
+    }
+    ostringstream os;
+    os << corpus << " " << fixed << setprecision(4) << speed;
+    lines.push_back(os.str());
+    ofstream ofs(file);
+    for (const auto& line: lines)
+        ofs << line << endl;
+    if (!ofs)
+        throw runtime_error("Unable to write \"" + file + "\"");
+}
+
+static double baseline(const string& file, const string& corpus)
+{
+    ifstream ifs(file);
+    string line;
+    while (getline(ifs, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        istringstream is(line);
+        string name;
+        double speed;
+        if (is >> name >> speed && name == corpus)
+            return speed;
+    } // end while //
+    throw runtime_error("No baseline for \"" + corpus + "\" in \"" +
+                        file + "\"");
+}
+
+int main(int argc, char *argv[])
+{
+    int arg{1};
+    const bool updating = (argc > 1 && strcmp(argv[1], "--update") == 0);
+    if (updating)
+        ++arg;
+    if (argc - arg < 3) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    const string corpus{argv[arg]};
+    const string file{argv[arg + 1]};
+    const double tolerance{atof(argv[arg + 2])};
+
+    try {
+        string text;
+        if (arg + 3 == argc) {
+            text = synthetic();
+        } else {
+            string files;
+            for (int i = arg + 3; i < argc; ++i)
+                files += read_file(argv[i]);
+            if (files.empty())
+                throw runtime_error("Empty corpus");
+            while (text.size() < corpusSize)
+                text += files;
+        }
+
+        const auto [seconds, reference_seconds] = measure(text);
+        // Formatting is as fast as the reference at 1:
+        const double speed = reference_seconds / seconds;
+        cout << corpus << ": " << static_cast<long>(tokens(text) / seconds)
+             << " tokens/s, " << fixed << setprecision(4) << speed
+             << " of the reference" << endl;
+        if (updating) {
+            update(file, corpus, speed);
+            return EXIT_SUCCESS;
+        }
+        const double expected = baseline(file, corpus);
+        const double change = (speed / expected - 1.0) * 100.0;
+        cout << "Baseline: " << expected << " of the reference ("
+             << showpos << setprecision(0) << change << noshowpos << "%)"
+             << endl;
+        if (change < -tolerance) {
+            cerr << corpus << ": more than " << tolerance
+                 << "% below the baseline" << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const exception& ex) {
+        cerr << "Fatal error: " << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+using namespace std;
+
+// Measures the time from starting the tool on a small file to its first
+// byte of output, the way an editor formatting on save sees it, in turns
+// with the same for cat, which does nothing but start and copy. Fails, if
+// the median of the runs is more than a factor above the one of cat, so
+// that the test holds on other boxes and under load, or above a limit in
+// microseconds, if one is given.
+
+static const int runs = 51;
+
+static void usage(const char *name)
+{
+    cerr << "Usage: " << name << " <tool> <factor> <limit us, 0 for none> "
+         << "<file>" << endl;
+}
+
+// Microseconds to the first byte of output, and to the exit of the tool,
+// found in the PATH, if it has no '/':
+static pair<double, double> run(const char *tool, char *const args[])
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+        throw runtime_error(string("pipe: ") + strerror(errno));
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    posix_spawn_file_actions_addclose(&actions, fds[1]);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null",
+                                     O_RDONLY, 0);
+    const auto start = chrono::steady_clock::now();
+    pid_t pid;
+    const int error = posix_spawnp(&pid, tool, &actions, nullptr, args,
+                                   environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    if (error) {
+        close(fds[0]);
+        throw runtime_error(string("Unable to start \"") + tool + "\": " +
+                            strerror(error));
+    }
+    char buffer[4096];
+    ssize_t size = read(fds[0], buffer, sizeof(buffer));
+    const auto first = chrono::steady_clock::now();
+    while (size > 0)
+        size = read(fds[0], buffer, sizeof(buffer));
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    const auto end = chrono::steady_clock::now();
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw runtime_error(string("\"") + tool + "\" failed");
+    const chrono::duration<double, micro> to_first = first - start;
+    const chrono::duration<double, micro> to_end = end - start;
+    return { to_first.count(), to_end.count() };
+}
+
+static double median(vector<double> v)
+{
+    nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 5) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char *tool{argv[1]};
+    const double factor{atof(argv[2])};
+    const double limit{atof(argv[3])};
+    char *file{argv[4]};
+    char *tool_args[] { argv[1], const_cast<char*>("-i"), file, nullptr };
+    char *cat_args[] { const_cast<char*>("cat"), file, nullptr };
+
+    try {
+        vector<double> to_first;
+        vector<double> to_end;
+        vector<double> cat_first;
+        run(tool, tool_args);   // Fill the page cache
+        run("cat", cat_args);
+        for (int i = 0; i < runs; ++i) {
+            const auto [first, end] = run(tool, tool_args);
+            to_first.push_back(first);
+            to_end.push_back(end);
+            cat_first.push_back(run("cat", cat_args).first);
+        } // end for //
+        const double first = median(to_first);
+        const double cat = median(cat_first);
+        cout << "startup: " << static_cast<long>(first)
+             << " us to the first output, "
+             << static_cast<long>(median(to_end)) << " us to the exit, "
+             << static_cast<long>(cat) << " us for cat" << endl;
+        if (first > factor * cat) {
+            cerr << "startup: more than " << factor << " times cat" << endl;
+            return EXIT_FAILURE;
+        }
+        if (limit > 0 && first > limit) {
+            cerr << "startup: more than " << limit << " us" << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const exception& ex) {
+        cerr << "Fatal error: " << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,31 @@
+# Split INPUT with BEAUTIFY into OUTPUT and compare the files written there
+# with the ones in EXPECTED, names and content:
+#
+#   cmake -DBEAUTIFY=<exe> -DINPUT=<file> -DEXPECTED=<dir>
+#         -DOUTPUT=<dir> -P split.cmake
+
+file(REMOVE_RECURSE ${OUTPUT})
+execute_process(COMMAND ${BEAUTIFY} --split-units ${OUTPUT} -i ${INPUT}
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Splitting ${INPUT} failed: ${result}")
+endif()
+
+file(GLOB expected RELATIVE ${EXPECTED} ${EXPECTED}/*)
+file(GLOB actual RELATIVE ${OUTPUT} ${OUTPUT}/*)
+list(SORT expected)
+list(SORT actual)
+if(NOT expected STREQUAL actual)
+    message(FATAL_ERROR "Files written: ${actual}\nexpected: ${expected}")
+endif()
+
+foreach(name ${expected})
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files
+                            ${OUTPUT}/${name} ${EXPECTED}/${name}
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        file(READ ${OUTPUT}/${name} text)
+        message(FATAL_ERROR "${OUTPUT}/${name} differs from "
+                            "${EXPECTED}/${name}:\n${text}")
+    endif()
+endforeach()
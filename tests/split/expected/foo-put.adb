@@ -0,0 +1,6 @@
+separate (Foo)
+
+procedure Put (X : Integer) is
+begin
+   Ada.Text_IO.Put_Line (Integer'Image (X));
+end Put;
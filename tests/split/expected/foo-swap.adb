@@ -0,0 +1,6 @@
+procedure Foo.Swap (A, B : in out Element) is
+   T : constant Element := A;
+begin
+   A := B;
+   B := T;
+end Foo.Swap;
@@ -0,0 +1,7 @@
+with Ada.Text_IO;
+use Ada.Text_IO;
+
+package body Foo is
+
+   procedure Put (X : Integer) is separate;
+end Foo;
@@ -0,0 +1,34 @@
+with Ada.Text_IO;
+package Foo is
+procedure Put (X : Integer);
+end Foo;
+
+with Ada.Text_IO; use Ada.Text_IO;
+package body Foo is
+procedure Put (X : Integer) is separate;
+end Foo;
+
+separate (Foo)
+procedure Put (X : Integer) is
+begin
+Ada.Text_IO.Put_Line (Integer'Image (X));
+end Put;
+
+private package Foo.Bar is
+Count : Natural := 0;
+end Foo.Bar;
+
+generic
+type Element is private;
+procedure Foo.Swap (A, B : in out Element);
+
+procedure Foo.Swap (A, B : in out Element) is
+T : constant Element := A;
+begin
+A := B;
+B := T;
+end Foo.Swap;
+
+package Ada.Extra is
+end Ada.Extra;
+--  End of the library.
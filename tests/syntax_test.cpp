@@ -0,0 +1,109 @@
+#include "symbol.hpp"
+#include "syntax.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Parses an input and compares the dump of its tree with the expected one:
+// kinds, nesting, names, body or declaration and lines. Also checks what
+// the dump does not show, the links and spans of the nodes.
+
+static string read_file(const string& file)
+{
+    ifstream ifs(file, ios::binary);
+    if (!ifs.is_open())
+        throw runtime_error("Unable to open \"" + file + "\"");
+    ostringstream os;
+    os << ifs.rdbuf();
+    return os.str();
+}
+
+// Each node lies within its parent, its next is the node after the last
+// one below it:
+static vector<string> links(const SyntaxTree& tree, string_view source)
+{
+    vector<string> errors;
+    auto error = [&errors] (uint32_t i, const string& what) {
+        errors.push_back("node " + to_string(i) + ": " + what);
+    };
+    if (tree.size() == 0 || tree[0].kind != SyntaxTree::Kind::ROOT ||
+        tree[0].parent != SyntaxTree::none) {
+        errors.push_back("no root");
+        return errors;
+    }
+    // Index after the last node below each node:
+    vector<uint32_t> after(tree.size());
+    for (uint32_t i = 0; i < tree.size(); ++i) {
+        after[i] = i + 1;
+        for (uint32_t p = tree[i].parent; p < i; p = tree[p].parent)
+            after[p] = i + 1;
+    } // end for //
+    for (uint32_t i = 1; i < tree.size(); ++i) {
+        const SyntaxTree::Node& n = tree[i];
+        if (n.parent >= i) {
+            error(i, "parent after the node");
+            continue;
+        }
+        const SyntaxTree::Node& p = tree[n.parent];
+        if (n.next != SyntaxTree::none && n.next != after[i])
+            error(i, "next not after the nodes below");
+        if (n.line > n.end_line || n.offset > n.end)
+            error(i, "ends before it starts");
+        if (n.line < p.line || n.end_line > p.end_line ||
+            n.offset < p.offset || n.end > p.end)
+            error(i, "span outside its parent");
+        if (n.name_length &&
+            (n.name < n.offset || n.name + n.name_length > n.end ||
+             n.name + n.name_length > source.size()))
+            error(i, "name outside its span");
+    } // end for //
+    return errors;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3) {
+        cerr << "Usage: " << argv[0] << " <input> <expected tree>" << endl;
+        return EXIT_FAILURE;
+    }
+    try {
+        const string source = read_file(argv[1]);
+        Lexer lexer(source);
+        SyntaxTree tree;
+        tree.parse(lexer);
+
+        bool passed = true;
+        ostringstream dump;
+        tree.dump(dump, source);
+        if (dump.str() != read_file(argv[2])) {
+            cerr << argv[1] << ": the tree differs from " << argv[2] << ":"
+                 << endl << dump.str();
+            passed = false;
+        }
+        for (const auto& error: links(tree, source)) {
+            cerr << argv[1] << ": " << error << endl;
+            passed = false;
+        }
+        // Parsing again starts anew:
+        Lexer again(source);
+        tree.parse(again);
+        ostringstream redump;
+        tree.dump(redump, source);
+        if (redump.str() != dump.str()) {
+            cerr << argv[1] << ": a second parse differs" << endl;
+            passed = false;
+        }
+        return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (const exception& ex) {
+        cerr << "Fatal error: " << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,193 @@
+#include "names.hpp"
+#include "symbol.hpp"
+#include "tokencache.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory_resource>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+// Checks the token cache: a miss before the first save, a hit with the
+// symbols of the lexer after it, a miss for changed content and for
+// corrupt files, which the next save replaces.
+
+static const char *text =
+    "with Ada.Text_IO;\n"
+    "procedure Main is\n"
+    "   --  A comment\n"
+    "   C : constant Character := 'x';\n"
+    "begin\n"
+    "   Ada.Text_IO.Put_Line (\"Hello\" & C & Character'Val (16#41#));\n"
+    "end Main;\n";
+
+static int failures{0};
+
+static void check(bool ok, const string& what)
+{
+    if (!ok) {
+        cerr << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+/**
+ * @brief CountingResource Counts the bytes allocated through it.
+ */
+class CountingResource: public pmr::memory_resource
+{
+public:
+    size_t bytes{0};
+
+private:
+    void *do_allocate(size_t size, size_t alignment) override {
+        bytes += size;
+        return pmr::new_delete_resource()->allocate(size, alignment);
+    }
+    void do_deallocate(void *p, size_t size, size_t alignment) override {
+        pmr::new_delete_resource()->deallocate(p, size, alignment);
+    }
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// The symbols of source up to END, one line each, with what the
+// formatter uses of them:
+static vector<string> symbols(SymbolSource& source)
+{
+    vector<string> lines;
+    while (true) {
+        const Symbol::Ref sym = source.get();
+        ostringstream os;
+        os << static_cast<int>(sym->kind()) << " " << sym->value() << " "
+           << (sym->id() != 0) << " " << sym->line() << ":" << sym->column()
+           << " " << sym->offset() << "+" << sym->length();
+        lines.push_back(os.str());
+        if (sym == Symbol::Kind::END)
+            break;
+    } // end while //
+    return lines;
+}
+
+static string read_file(const filesystem::path& file)
+{
+    ifstream ifs(file, ios::binary);
+    ostringstream os;
+    os << ifs.rdbuf();
+    return os.str();
+}
+
+static void write_file(const filesystem::path& file, const string& data)
+{
+    ofstream ofs(file, ios::binary | ios::trunc);
+    ofs.write(data.data(), data.size());
+}
+
+// Lex source and save its symbols, return them:
+static vector<string> save(const TokenCache& cache, string_view source)
+{
+    NameTable names;
+    Lexer lexer(source, &names);
+    TokenRecorder recorder(lexer);
+    const vector<string> lexed = symbols(recorder);
+    cache.save(recorder);
+    return lexed;
+}
+
+static bool hit(const TokenCache& cache)
+{
+    NameTable names;
+    return cache.open(names) != nullptr;
+}
+
+int main()
+{
+    const filesystem::path dir = filesystem::temp_directory_path() /
+        ("tokencache_test." + to_string(getpid()));
+    filesystem::remove_all(dir);
+
+    const TokenCache cache(dir.string(), text, true);
+    check(!hit(cache), "miss before the first save");
+    const vector<string> lexed = save(cache, text);
+
+    // A hit delivers the symbols of the lexer, from memory:
+    {
+        NameTable names;
+        CountingResource memory;
+        auto cached = cache.open(names, &memory);
+        check(cached != nullptr, "hit after the save");
+        if (cached) {
+            check(symbols(*cached) == lexed, "cached symbols as lexed");
+            check(memory.bytes > 0, "cached symbols from memory");
+        }
+    }
+
+    // Skipping goes on at the first symbol at the offset:
+    {
+        NameTable names;
+        auto cached = cache.open(names);
+        const size_t offset = string_view(text).find("begin");
+        if (cached && cached->skip(offset, 5))
+            check(cached->get()->value() == "begin", "skip to \"begin\"");
+    }
+
+    // Changed content and encoding miss:
+    const string changed = string(text) + "--  More\n";
+    check(!hit(TokenCache(dir.string(), changed, true)),
+          "miss for changed content");
+    check(!hit(TokenCache(dir.string(), text, false)),
+          "miss for another encoding");
+
+    // Corrupt files miss and are replaced by the next save:
+    filesystem::path file;
+    for (const auto& entry: filesystem::directory_iterator(dir))
+        if (entry.path().extension() == ".tok")
+            file = entry.path();
+    const string good = read_file(file);
+    const size_t first = sizeof(TokenCache::Header);
+    auto corrupt = [&] (const string& what,
+                        const function<void (string& data)>& change) {
+        string data = good;
+        change(data);
+        write_file(file, data);
+        check(!hit(cache), "miss for " + what);
+        save(cache, text);
+        check(read_file(file) == good, "replaced after " + what);
+    };
+    corrupt("a truncated file", [] (string& data) {
+        data.pop_back();
+    });
+    corrupt("a wrong magic", [] (string& data) {
+        data[0] ^= 1;
+    });
+    corrupt("an unknown kind", [first] (string& data) {
+        data[first + offsetof(TokenCache::Record, kind)] = 0x7f;
+    });
+    corrupt("a value outside the pool", [first] (string& data) {
+        const uint32_t value = 0x7fffffff;
+        memcpy(&data[first + offsetof(TokenCache::Record, value)],
+               &value, sizeof(value));
+    });
+    corrupt("a symbol outside the source", [first] (string& data) {
+        const uint32_t offset = 0x7fffffff;
+        memcpy(&data[first + offsetof(TokenCache::Record, offset)],
+               &offset, sizeof(offset));
+    });
+
+    filesystem::remove_all(dir);
+    if (failures)
+        return EXIT_FAILURE;
+    cout << "Token cache checks passed" << endl;
+    return EXIT_SUCCESS;
+}
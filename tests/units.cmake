@@ -0,0 +1,46 @@
+# Format INPUT with BEAUTIFY, then its formatted text again, with and
+# without the formatted units kept in a token cache. The second run with
+# the cache copies the units it knows from the first one. Text and source
+# map must be the ones of the run without it:
+#
+#   cmake -DBEAUTIFY=<exe> -DINPUT=<file> -DOUTPUT=<dir> -P units.cmake
+
+file(REMOVE_RECURSE ${OUTPUT})
+file(MAKE_DIRECTORY ${OUTPUT})
+
+function(run name)
+    execute_process(COMMAND ${BEAUTIFY} ${ARGN} -o ${OUTPUT}/${name}.adb
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Formatting for ${name} failed: ${result}")
+    endif()
+endfunction()
+
+function(compare name expected)
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files
+                            ${OUTPUT}/${name} ${OUTPUT}/${expected}
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${OUTPUT}/${name} differs from "
+                            "${OUTPUT}/${expected}")
+    endif()
+endfunction()
+
+run(formatted -i ${INPUT})
+run(again -i ${OUTPUT}/formatted.adb -r ${OUTPUT}/again.map)
+run(cached -t ${OUTPUT}/cache -i ${INPUT})
+compare(cached.adb formatted.adb)
+
+foreach(i 1 2)
+    run(again${i} -t ${OUTPUT}/cache -i ${OUTPUT}/formatted.adb
+        -r ${OUTPUT}/again${i}.map)
+    compare(again${i}.adb again.adb)
+    compare(again${i}.map again.map)
+endforeach()
+
+# Magic, version and count come before the hashes:
+file(READ ${OUTPUT}/cache/formatted-units units HEX)
+string(LENGTH "${units}" length)
+if(length LESS 48)
+    message(FATAL_ERROR "No formatted units kept in ${OUTPUT}/cache")
+endif()
@@ -0,0 +1,165 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+using namespace std;
+using namespace filesystem;
+
+// Starts the tool watching a scratch directory, writes an input below it
+// once the tool watches all of it and waits for the tool to report it
+// formatted. Fails, if that takes longer than the timeout, or if the file
+// is not the expected text then.
+
+static void usage(const char *name)
+{
+    cerr << "Usage: " << name << " <tool> <input> <expected> <dir> "
+         << "<timeout s>" << endl;
+}
+
+static string read_file(const path& file)
+{
+    ifstream ifs(file, ios::binary);
+    if (!ifs)
+        throw runtime_error("Unable to read \"" + file.string() + "\"");
+    stringstream text;
+    text << ifs.rdbuf();
+    return text.str();
+}
+
+/**
+ * @brief Tool The tool running in watch mode, with its output and errors
+ *        in one pipe, stopped when it goes out of scope.
+ */
+class Tool
+{
+public:
+    Tool(char *const args[]) {
+        int fds[2];
+        if (pipe(fds) != 0)
+            throw runtime_error(string("pipe: ") + strerror(errno));
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, fds[1], STDERR_FILENO);
+        posix_spawn_file_actions_addclose(&actions, fds[0]);
+        posix_spawn_file_actions_addclose(&actions, fds[1]);
+        const int error = posix_spawn(&pid, args[0], &actions, nullptr,
+                                      args, environ);
+        posix_spawn_file_actions_destroy(&actions);
+        close(fds[1]);
+        if (error) {
+            close(fds[0]);
+            throw runtime_error(string("Unable to start \"") + args[0] +
+                                "\": " + strerror(error));
+        }
+        fd = fds[0];
+    }
+
+    ~Tool() {
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+        close(fd);
+    }
+
+    // Wait until the tool has count inotify watches, false at the deadline:
+    bool wait_watching(size_t count, chrono::steady_clock::time_point end) {
+        const path fds{"/proc/" + to_string(pid) + "/fdinfo"};
+        while (chrono::steady_clock::now() < end) {
+            size_t watches{0};
+            error_code ec;
+            for (const auto& entry: directory_iterator(fds, ec)) {
+                ifstream info(entry.path());
+                string line;
+                while (getline(info, line))
+                    watches += line.starts_with("inotify wd:");
+            } // end for //
+            if (watches >= count)
+                return true;
+            usleep(10000);
+        } // end while //
+        return false;
+    }
+
+    // Wait until the output has text, false at the deadline or exit:
+    bool wait_for(const string& text, chrono::steady_clock::time_point end) {
+        while (output.find(text) == string::npos) {
+            const auto left = chrono::duration_cast<chrono::milliseconds>(
+                end - chrono::steady_clock::now()).count();
+            pollfd p{fd, POLLIN, 0};
+            if (left <= 0 || poll(&p, 1, left) <= 0)
+                return false;
+            char buffer[4096];
+            const ssize_t size = read(fd, buffer, sizeof(buffer));
+            if (size <= 0)
+                return false;
+            output.append(buffer, size);
+        } // end while //
+        return true;
+    }
+
+    string output{};
+
+private:
+    pid_t pid;
+    int fd;
+};
+
+int main(int argc, char *argv[])
+{
+    if (argc != 6) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    const path input{argv[2]};
+    const path expected{argv[3]};
+    const path dir{argv[4]};
+    const auto timeout = chrono::seconds(atoi(argv[5]));
+    char *tool_args[] { argv[1], const_cast<char*>("-w"), argv[4], nullptr };
+
+    try {
+        remove_all(dir);
+        create_directories(dir / "src");
+        const path file{dir / "src" / input.filename()};
+        Tool tool(tool_args);
+        const auto end = chrono::steady_clock::now() + timeout;
+        // The directory and the one below it:
+        if (!tool.wait_watching(2, end)) {
+            cerr << "watch: not watching:\n" << tool.output << endl;
+            return EXIT_FAILURE;
+        }
+        const auto start = chrono::steady_clock::now();
+        copy_file(input, file);
+        if (!tool.wait_for(input.filename().string() + ": formatted", end)) {
+            cerr << "watch: " << file.string() << " not formatted:\n"
+                 << tool.output << endl;
+            return EXIT_FAILURE;
+        }
+        const chrono::duration<double, milli> took =
+            chrono::steady_clock::now() - start;
+        cout << "watch: formatted after " << took.count() << " ms" << endl;
+        if (read_file(file) != read_file(expected)) {
+            cerr << "watch: " << file.string() << " differs from "
+                 << expected.string() << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const exception& ex) {
+        cerr << "Fatal error: " << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
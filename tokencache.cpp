@@ -0,0 +1,198 @@
+#include "tokencache.hpp"
+#include "keywords.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char magic[8] {'A', 'D', 'A', 'B', 'T', 'O', 'K', '\0'};
+
+// The layout is part of the file format:
+static_assert(sizeof(TokenCache::Header) == 40);
+static_assert(sizeof(TokenCache::Record) == 28);
+
+/**
+ * @brief TokenReader Symbols from a mapped cache file.
+ */
+class TokenReader: public SymbolSource
+{
+public:
+    TokenReader(void *_map, size_t _map_size, NameTable& _names,
+                pmr::memory_resource *_memory):
+        map{_map}, map_size{_map_size}, names{_names}, memory{_memory}
+    {
+        const char *base = static_cast<const char*>(map);
+        header = reinterpret_cast<const TokenCache::Header*>(base);
+        records = reinterpret_cast<const TokenCache::Record*>(
+            base + sizeof(TokenCache::Header));
+        pool = reinterpret_cast<const char*>(records + header->count);
+        advance();
+    }
+
+    virtual ~TokenReader() { munmap(map, map_size); }
+
+    virtual const Symbol::Ref get() {
+        cur_sym = next_sym;
+        advance();
+        return cur_sym;
+    }
+
+    virtual const Symbol::Ref next() const { return next_sym; }
+
+    // Records are in the order of their offsets:
+    virtual bool skip(size_t offset, int /*line*/) {
+        index = lower_bound(records, records + header->count, offset,
+                            [] (const TokenCache::Record& r, size_t o) {
+            return r.offset < o;
+        }) - records;
+        advance();
+        return true;
+    }
+
+private:
+    void advance() {
+        if (index == header->count) {
+            next_sym = make_symbol<SymbolEnd>(memory);
+            return;
+        }
+        const TokenCache::Record& r = records[index++];
+        const Symbol::Kind kind = static_cast<Symbol::Kind>(r.kind);
+        const string_view value(pool + r.value, r.value_length);
+        if (kind == Symbol::Kind::IDENTIFIER)
+            next_sym = make_symbol<SymbolIdentifier>(memory,
+                                                     names.intern(value));
+        else
+            next_sym = make_symbol<SymbolRaw>(memory, kind, value);
+        next_sym->locate(r.line, r.column, r.offset, r.length);
+    }
+
+    void *map;
+    size_t map_size;
+    NameTable& names;
+    pmr::memory_resource *memory;
+    const TokenCache::Header *header;
+    const TokenCache::Record *records;
+    const char *pool;
+    uint32_t index{0};
+    Symbol::Ref cur_sym{};
+    Symbol::Ref next_sym{};
+};
+
+const Symbol::Ref TokenRecorder::get()
+{
+    const Symbol::Ref sym = source.get();
+    if (end)
+        return sym;
+    TokenCache::Record r{};
+    r.kind = static_cast<uint8_t>(sym->kind());
+    r.keyword = keyword(sym->value());
+    r.line = sym->line();
+    r.column = sym->column();
+    r.offset = sym->offset();
+    r.length = sym->length();
+    r.value_length = sym->value().size();
+    // Each spelling of a name goes into the pool once:
+    const auto it = sym->id() ? pooled.find(&sym->value()) : pooled.end();
+    if (it != pooled.end()) {
+        r.value = it->second;
+    } else {
+        r.value = pool.size();
+        pool.append(sym->value());
+        if (sym->id())
+            pooled.emplace(&sym->value(), r.value);
+    }
+    records.push_back(r);
+    end = sym == Symbol::Kind::END;
+    return sym;
+}
+
+TokenCache::TokenCache(const string& dir, string_view source, bool utf8):
+    hash{content_hash(source) ^ !utf8}, size{source.size()}
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.tok",
+             static_cast<unsigned long long>(hash));
+    file = (filesystem::path(dir) / name).string();
+}
+
+unique_ptr<SymbolSource> TokenCache::open(NameTable& names,
+                                          pmr::memory_resource *memory) const
+{
+    const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return nullptr;
+    struct stat st;
+    void *map{MAP_FAILED};
+    if (fstat(fd, &st) == 0 && st.st_size >= off_t(sizeof(Header)))
+        map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+        return nullptr;
+    // Check the file before trusting any offset in it:
+    const size_t map_size = st.st_size;
+    const Header& h = *static_cast<const Header*>(map);
+    bool valid = memcmp(h.magic, magic, sizeof(magic)) == 0 &&
+        h.version == version && h.source_hash == hash &&
+        h.source_size == size &&
+        map_size == sizeof(Header) + h.count * sizeof(Record) + h.pool_size;
+    const Record *records = reinterpret_cast<const Record*>(
+        static_cast<const char*>(map) + sizeof(Header));
+    // Kinds known, values in the pool, spans in the source and in order:
+    for (uint32_t i = 0; valid && i < h.count; ++i) {
+        const Record& r = records[i];
+        valid = r.kind <= static_cast<uint8_t>(Symbol::Kind::COMMENT) &&
+            uint64_t(r.value) + r.value_length <= h.pool_size &&
+            uint64_t(r.offset) + r.length <= size &&
+            (i == 0 || records[i - 1].offset <= r.offset);
+    } // end for //
+    if (!valid) {
+        munmap(map, map_size);
+        return nullptr;
+    }
+    return unique_ptr<SymbolSource>(
+        new TokenReader(map, map_size, names, memory));
+}
+
+void TokenCache::save(const TokenRecorder& recorder) const
+{
+    if (!recorder.complete())
+        return;
+    Header h{};
+    memcpy(h.magic, magic, sizeof(magic));
+    h.version = version;
+    h.count = recorder.records.size();
+    h.source_hash = hash;
+    h.source_size = size;
+    h.pool_size = recorder.pool.size();
+    // Write under a private name, so that readers never see half a file:
+    const string temp = file + "." + to_string(getpid()) + "." +
+        to_string(std::hash<thread::id>()(this_thread::get_id())) + ".tmp";
+    error_code ec;
+    filesystem::create_directories(filesystem::path(file).parent_path(), ec);
+    {
+        ofstream ofs(temp, ios::binary);
+        ofs.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        ofs.write(reinterpret_cast<const char*>(recorder.records.data()),
+                  recorder.records.size() * sizeof(Record));
+        ofs.write(recorder.pool.data(), recorder.pool.size());
+        if (!ofs) {
+            ofs.close();
+            filesystem::remove(temp, ec);
+            return;
+        }
+    }
+    filesystem::rename(temp, file, ec);
+    if (ec)
+        filesystem::remove(temp, ec);
+}
@@ -0,0 +1,93 @@
+#ifndef TOKENCACHE_HPP
+#define TOKENCACHE_HPP
+
+#include "names.hpp"
+#include "symbol.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief TokenCache Keeps the symbol stream of a source in a binary file,
+ *        named after the content hash of the source, so that a changed
+ *        source never finds a stale file. The file is mapped and its
+ *        records are used in place. Numbers are in native byte order.
+ *
+ *        Layout: Header, Record[count], string pool of pool_size bytes.
+ */
+class TokenCache
+{
+public:
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t count;
+        std::uint64_t source_hash;
+        std::uint64_t source_size;
+        std::uint64_t pool_size;
+    };
+
+    struct Record {
+        std::uint8_t kind;          // Symbol::Kind
+        std::uint8_t keyword;       // keyword(), 0 if none
+        std::uint16_t reserved;
+        std::uint32_t line;
+        std::uint32_t column;
+        std::uint32_t offset;       // Source span
+        std::uint32_t length;
+        std::uint32_t value;        // Value in the string pool
+        std::uint32_t value_length;
+    };
+
+    // Bump, whenever the lexer changes the symbols it makes:
+    static const std::uint32_t version = 4;
+
+    // Columns depend on the encoding, so it is part of the key:
+    TokenCache(const std::string& dir, std::string_view source, bool utf8);
+
+    // Symbols from the cache file, null if there is no valid one.
+    // Identifiers are interned in names. Symbols come from memory, if
+    // given, as the ones of the Lexer:
+    std::unique_ptr<SymbolSource> open(
+        NameTable& names, std::pmr::memory_resource *memory = nullptr) const;
+    // Write the cache file, if the recorder has seen the END symbol.
+    // Failing to write is not an error, the next run lexes again:
+    void save(const class TokenRecorder& recorder) const;
+
+private:
+    std::string file{};
+    std::uint64_t hash;
+    std::uint64_t size;
+};
+
+/**
+ * @brief TokenRecorder Passes the symbols of another source on and
+ *        records them for TokenCache::save().
+ */
+class TokenRecorder: public SymbolSource
+{
+public:
+    TokenRecorder(SymbolSource& _source): source{_source} {}
+
+    virtual const Symbol::Ref get();
+    virtual const Symbol::Ref next() const { return source.next(); }
+
+    bool complete() const { return end; }
+
+private:
+    friend class TokenCache;
+
+    SymbolSource& source;
+    std::vector<TokenCache::Record> records{};
+    std::string pool{};
+    // Where each interned spelling is in the pool already:
+    std::unordered_map<const std::pmr::string*, std::uint32_t> pooled{};
+    bool end{false};
+};
+
+#endif // TOKENCACHE_HPP
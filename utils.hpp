@@ -2,9 +2,13 @@
 #define UTILS_HPP
 
 #include <string>
+#include <string_view>
 #include <algorithm>
+#include <array>
 #include <cctype>
-#
+#include <cstdint>
+#include <cstring>
+
 // trim from start (in place)
 inline void ltrim(std::string &s) {
     s.erase(s.begin(), std::find_if(s.begin(), s.end(), [](unsigned char ch) {
@@ -25,6 +29,14 @@ inline void trim(std::string &s) {
     rtrim(s);
 }
 
+// Copy in lower case:
+inline std::string to_lower(std::string_view s) {
+    std::string l{s};
+    for (auto& c: l)
+        c = std::tolower(static_cast<unsigned char>(c));
+    return l;
+}
+
 inline int fm_hex(const unsigned char x) {
     if ((x >= '0') && (x <= '9'))
         return x - '0';
@@ -38,13 +50,46 @@ inline int fm_hex(const unsigned char x) {
 
 inline std::string to_hex(const unsigned char x) {
     static const char rg[]{ "0123456789ABCDEF" };
-    const char s[] {rg[x >> 8], rg[x & 15], '\0'};
+    const char s[] {rg[x >> 4], rg[x & 15], '\0'};
     return std::string(s);
 }
 
+// Letters, digits, '_', '\'' and every byte of a non-ASCII character,
+// in a table, so that scanning a name takes no branches:
+inline constexpr std::array<bool, 256> tokenchars = [] {
+    std::array<bool, 256> t{};
+    for (int c = 0; c < 256; ++c)
+        t[c] = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+            (c >= 'A' && c <= 'Z') || c == '_' || c == '\'' || c >= 0x80;
+    return t;
+}();
+
 inline bool is_tokenchar(const unsigned char x) {
-    return ((x >= '0' && x <= '9') || (x >= 'a' && x <= 'z') ||
-            (x >= 'A' && x <= 'Z') || x == '_' || x == '\'');
+    return tokenchars[x];
+}
+
+// Characters in UTF-8 text, the bytes that do not continue a sequence:
+inline std::size_t text_width(std::string_view s) {
+    std::size_t width = 0;
+    for (const unsigned char c: s)
+        width += (c & 0xC0) != 0x80;
+    return width;
+}
+
+// 64 bit hash of a byte string, eight bytes per step:
+inline std::uint64_t content_hash(std::string_view s) {
+    std::uint64_t h = 0x9E3779B97F4A7C15ull ^ s.size();
+    std::size_t i = 0;
+    for (; i + 8 <= s.size(); i += 8) {
+        std::uint64_t w;
+        std::memcpy(&w, s.data() + i, 8);
+        h = (h ^ w) * 0xFF51AFD7ED558CCDull;
+        h ^= h >> 32;
+    }
+    std::uint64_t w = 0;
+    std::memcpy(&w, s.data() + i, s.size() - i);
+    h = (h ^ w) * 0xC4CEB9FE1A85EC53ull;
+    return h ^ (h >> 29);
 }
 
 #endif // UTILS_HPP
@@ -0,0 +1,84 @@
+#include "verify.hpp"
+#include "utils.hpp"
+
+#include <cctype>
+
+using namespace std;
+
+void TokenHash::add(const Symbol& sym, string_view text)
+{
+    switch (sym.kind()) {
+    case Symbol::Kind::END:
+    case Symbol::Kind::NL:
+        return;
+    case Symbol::Kind::COMMENT:
+        // The scope levels -v writes are no text, "--  << ... >>":
+        text = sym.value();
+        if (text.size() > 4 && text.substr(4).starts_with("<< ") &&
+            text.find(" Scope Level ") != string_view::npos)
+            return;
+        // Word by word, as refilling moves words to other lines:
+        for (size_t pos = 2, end; pos < text.size(); pos = end) {
+            pos = text.find_first_not_of(' ', pos);
+            if (pos == string_view::npos)
+                break;
+            end = min(text.find(' ', pos), text.size());
+            comments += content_hash(text.substr(pos, end - pos));
+        } // end for //
+        return;
+    case Symbol::Kind::IDENTIFIER:
+        folded.assign(text);
+        for (auto& c: folded)
+            c = tolower(static_cast<unsigned char>(c));
+        text = folded;
+        break;
+    default:
+        break;
+    } // end switch //
+    hash = (hash ^ content_hash(text) ^ static_cast<uint64_t>(sym.kind())) *
+        0x9E3779B97F4A7C15ull;
+    hash ^= hash >> 29;
+    ++count;
+}
+
+const Symbol::Ref HashingSource::get()
+{
+    const Symbol::Ref sym = source.get();
+    if (sym != Symbol::Kind::COMMENT && sym != Symbol::Kind::NL)
+        header = false;
+    if (!header)
+        hash.add(*sym, input.substr(sym->offset(), sym->length()));
+    return sym;
+}
+
+void VerifySink::write(string_view text)
+{
+    out.write(text);
+    size_t end;
+    while ((end = text.find('\n')) != string_view::npos) {
+        if (line.empty()) {
+            lex(text.substr(0, end));
+        } else {
+            line.append(text.substr(0, end));
+            lex(line);
+            line.clear();
+        }
+        text.remove_prefix(end + 1);
+    } // end while //
+    line.append(text);
+}
+
+void VerifySink::finish()
+{
+    lex(line);
+    line.clear();
+    out.finish();
+}
+
+void VerifySink::lex(string_view text)
+{
+    Lexer lexer(text);
+    for (Symbol::Ref sym = lexer.get(); sym != Symbol::Kind::END;
+         sym = lexer.get())
+        _hash.add(*sym, text.substr(sym->offset(), sym->length()));
+}
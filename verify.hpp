@@ -0,0 +1,90 @@
+#ifndef VERIFY_HPP
+#define VERIFY_HPP
+
+#include "ada_beautify.hpp"
+#include "symbol.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief TokenHash Hash of the significant symbols of a text, that is of
+ *        all but line ends and layout. Symbols are hashed by their source
+ *        text, identifiers and reserved words ignoring case. The words
+ *        of comments go into a separate sum, which ignores their order,
+ *        as the layout moves trailing comments to a line of their own
+ *        and refilling moves words from line to line.
+ */
+class TokenHash
+{
+public:
+    // Symbol sym, text is its span in the source:
+    void add(const Symbol& sym, std::string_view text);
+
+    bool operator==(const TokenHash& other) const {
+        return hash == other.hash && count == other.count &&
+            comments == other.comments;
+    }
+
+    std::uint64_t symbols() const { return count; }
+
+private:
+    std::uint64_t hash{0};
+    std::uint64_t count{0};
+    std::uint64_t comments{0};
+    std::string folded{};
+};
+
+/**
+ * @brief HashingSource Passes on the symbols of another source and hashes
+ *        them on the way. Comments before the first other symbol are not
+ *        hashed, the Formatter drops these.
+ */
+class HashingSource: public SymbolSource
+{
+public:
+    HashingSource(SymbolSource& _source, std::string_view _input,
+                  TokenHash& _hash):
+        source{_source}, input{_input}, hash{_hash} {}
+
+    virtual const Symbol::Ref get();
+    virtual const Symbol::Ref next() const { return source.next(); }
+
+private:
+    SymbolSource& source;
+    std::string_view input;
+    TokenHash& hash;
+    bool header{true};
+};
+
+/**
+ * @brief VerifySink Passes the formatted text on to another sink and
+ *        hashes its symbols while it is written. The text is lexed line
+ *        by line, so no more than a line is held.
+ */
+class VerifySink: public ada_beautify::OutputSink
+{
+public:
+    VerifySink(ada_beautify::OutputSink& _out): out{_out} {}
+
+    virtual void write(std::string_view text);
+    virtual void diagnostic(const ada_beautify::Diagnostic& diag) {
+        out.diagnostic(diag);
+    }
+    virtual void unit(int line) { out.unit(line); }
+    virtual void origin(int line) { out.origin(line); }
+    virtual bool done() const { return out.done(); }
+    virtual void finish();
+
+    const TokenHash& hash() const { return _hash; }
+
+private:
+    void lex(std::string_view text);
+
+    ada_beautify::OutputSink& out;
+    std::string line{};
+    TokenHash _hash{};
+};
+
+#endif // VERIFY_HPP
@@ -0,0 +1,118 @@
+#include "watch.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace filesystem;
+
+static const uint32_t mask =
+    IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR;
+
+static bool is_source(const path& file)
+{
+    const path ext = file.extension();
+    return ext == ".adb" || ext == ".ads" || ext == ".ada";
+}
+
+Watcher::Watcher(const path& dir)
+{
+    if (!is_directory(dir))
+        throw runtime_error(string("Directory not found: \"") +
+                            dir.string() + "\"");
+    fd = inotify_init1(IN_CLOEXEC);
+    if (fd < 0)
+        throw runtime_error(string("Unable to watch: ") + strerror(errno));
+    add(dir, false);
+}
+
+Watcher::~Watcher()
+{
+    close(fd);
+}
+
+void Watcher::run(actionType action)
+{
+    while (true) {
+        pollfd p{fd, POLLIN, 0};
+        const int n = poll(&p, 1, pending.empty() ? -1 : debounce);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            throw runtime_error(string("Unable to watch: ") +
+                                strerror(errno));
+        }
+        if (n > 0) {
+            events();
+        } else {
+            // Quiet for long enough:
+            const vector<path> files(pending.begin(), pending.end());
+            pending.clear();
+            action(files);
+        }
+    } // end while //
+}
+
+void Watcher::add(const path& dir, bool scan)
+{
+    watch(dir);
+    error_code ec;
+    for (recursive_directory_iterator it(
+             dir, directory_options::skip_permission_denied, ec), end;
+         !ec && it != end; it.increment(ec)) {
+        if (it->is_directory(ec))
+            watch(it->path());
+        else if (scan && is_source(it->path()))
+            // Written before its directory was watched:
+            pending.insert(it->path());
+    } // end for //
+}
+
+void Watcher::watch(const path& dir)
+{
+    const int wd = inotify_add_watch(fd, dir.c_str(), mask);
+    if (wd < 0)
+        cerr << "Unable to watch \"" << dir.string() << "\": "
+             << strerror(errno) << endl;
+    else
+        dirs[wd] = dir;
+}
+
+// Read the events that are there, without blocking:
+void Watcher::events()
+{
+    alignas(inotify_event) char buffer[16384];
+    const ssize_t size = read(fd, buffer, sizeof(buffer));
+    if (size <= 0)
+        return;
+    for (ssize_t pos = 0; pos < size; ) {
+        const auto *e = reinterpret_cast<const inotify_event*>(buffer + pos);
+        pos += sizeof(inotify_event) + e->len;
+        if (e->mask & IN_Q_OVERFLOW) {
+            cerr << "Watch: events lost, save the files again" << endl;
+            continue;
+        }
+        if (e->mask & IN_IGNORED) {
+            dirs.erase(e->wd);
+            continue;
+        }
+        const auto dir = dirs.find(e->wd);
+        if (dir == dirs.end() || !e->len)
+            continue;
+        const path file = dir->second / e->name;
+        if (e->mask & IN_ISDIR) {
+            if (e->mask & (IN_CREATE | IN_MOVED_TO))
+                add(file, true);
+        } else if ((e->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) &&
+                   is_source(file)) {
+            pending.insert(file);
+        }
+    } // end for //
+}
@@ -0,0 +1,42 @@
+#ifndef WATCH_HPP
+#define WATCH_HPP
+
+#include <filesystem>
+#include <functional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Watcher Waits with inotify for Ada sources below a directory to
+ *        be written. Bursts of writes are debounced: the changed files
+ *        are handed on once no event came for debounce milliseconds.
+ *        Directories created later are watched as they appear, the tree
+ *        is never scanned again.
+ */
+class Watcher
+{
+public:
+    typedef std::function<void (const std::vector<std::filesystem::path>&
+                                files)> actionType;
+
+    static const int debounce = 50;     // Milliseconds
+
+    Watcher(const std::filesystem::path& dir);
+    ~Watcher();
+
+    // Run action on the changed files, until the process is stopped:
+    void run(actionType action);
+
+private:
+    // Watch dir and the directories below it:
+    void add(const std::filesystem::path& dir, bool scan);
+    void watch(const std::filesystem::path& dir);
+    void events();
+
+    int fd;
+    std::unordered_map<int, std::filesystem::path> dirs{};
+    std::set<std::filesystem::path> pending{};
+};
+
+#endif // WATCH_HPP